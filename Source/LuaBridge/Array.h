@@ -19,9 +19,8 @@ struct Stack<std::array<T, s>>
         lua_createtable(L, static_cast<int>(s), 0);
         for (std::size_t i = 0; i < s; ++i)
         {
-            lua_pushinteger(L, static_cast<lua_Integer>(i + 1));
             Stack<T>::push(L, array[i]);
-            lua_settable(L, -3);
+            lua_rawseti(L, -2, static_cast<int>(i + 1));
         }
     }
 
@@ -32,30 +31,28 @@ struct Stack<std::array<T, s>>
             luaL_error(L, "#%d argument must be table", index);
         }
 
-        std::size_t const tableSize = static_cast<std::size_t>(get_length(L, index));
+        std::size_t const tableSize = static_cast<std::size_t>(get_rawlength(L, index));
 
         if (tableSize != s)
         {
-            luaL_error(L, "array size must be %d ", s);
+            luaL_error(L, "array size must be %d ", static_cast<int>(s));
         }
 
         std::array<T, s> array = {};
 
         int const absindex = lua_absindex(L, index);
-        lua_pushnil(L);
-        int arrayIndex = 0;
-        while (lua_next(L, absindex) != 0)
+        for (std::size_t i = 0; i < s; ++i)
         {
-            array[arrayIndex] = Stack<T>::get(L, -1);
+            lua_rawgeti(L, absindex, static_cast<int>(i + 1));
+            array[i] = Stack<T>::get(L, -1);
             lua_pop(L, 1);
-            ++arrayIndex;
         }
         return array;
     }
 
     static bool isInstance(lua_State* L, int index)
     {
-        return lua_istable(L, index) && get_length(L, index) == s;
+        return lua_istable(L, index) && get_rawlength(L, index) == static_cast<int>(s);
     }
 };
 
@@ -16,13 +16,12 @@ struct Stack<std::list<T>>
     static void push(lua_State* L, std::list<T> const& list)
     {
         lua_createtable(L, static_cast<int>(list.size()), 0);
-        typename std::list<T>::const_iterator item = list.begin();
-        for (std::size_t i = 1; i <= list.size(); ++i)
+        int i = 1;
+        for (typename std::list<T>::const_iterator item = list.begin(); item != list.end();
+             ++item, ++i)
         {
-            lua_pushinteger(L, static_cast<lua_Integer>(i));
             Stack<T>::push(L, *item);
-            lua_settable(L, -3);
-            ++item;
+            lua_rawseti(L, -2, i);
         }
     }
 
@@ -33,12 +32,14 @@ struct Stack<std::list<T>>
             luaL_error(L, "#%d argument must be a table", index);
         }
 
+        int const size = get_rawlength(L, index);
+
         std::list<T> list;
 
         int const absindex = lua_absindex(L, index);
-        lua_pushnil(L);
-        while (lua_next(L, absindex) != 0)
+        for (int i = 1; i <= size; ++i)
         {
+            lua_rawgeti(L, absindex, i);
             list.push_back(Stack<T>::get(L, -1));
             lua_pop(L, 1);
         }
@@ -22,11 +22,16 @@
 #include <LuaBridge/detail/ClassInfo.h>
 #include <LuaBridge/detail/Constructor.h>
 #include <LuaBridge/detail/FuncTraits.h>
+#include <LuaBridge/detail/HandleMap.h>
 #include <LuaBridge/detail/Iterator.h>
 #include <LuaBridge/detail/LuaException.h>
+#include <LuaBridge/detail/LuaFunction.h>
 #include <LuaBridge/detail/LuaHelpers.h>
+#include <LuaBridge/detail/LuaPath.h>
 #include <LuaBridge/detail/LuaRef.h>
+#include <LuaBridge/detail/LuaValue.h>
 #include <LuaBridge/detail/Namespace.h>
+#include <LuaBridge/detail/Options.h>
 #include <LuaBridge/detail/Security.h>
 #include <LuaBridge/detail/Stack.h>
 #include <LuaBridge/detail/TypeList.h>
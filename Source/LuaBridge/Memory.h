@@ -0,0 +1,159 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <LuaBridge/detail/Stack.h>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace luabridge {
+
+namespace detail {
+
+//============================================================================
+/**
+  Wraps a std::shared_ptr to a class object.
+
+  The shared pointer is stored in the userdata with its object type erased,
+  so copying it to or from Lua only touches its control block. Getting it
+  back for the class or a base class shares the same control block.
+*/
+class UserdataSharedPtr : public UserdataContainer
+{
+private:
+    UserdataSharedPtr(UserdataSharedPtr const&);
+    UserdataSharedPtr& operator=(UserdataSharedPtr const&);
+
+    explicit UserdataSharedPtr(std::shared_ptr<void>&& p)
+        : UserdataContainer(&destroy), m_sp(std::move(p))
+    {
+        m_p = m_sp.get();
+    }
+
+    ~UserdataSharedPtr() {}
+
+    static void destroy(UserdataContainer* ud)
+    {
+        static_cast<UserdataSharedPtr*>(ud)->~UserdataSharedPtr();
+    }
+
+    std::shared_ptr<void> m_sp;
+
+public:
+    /**
+      Push a shared pointer to object.
+
+      @tparam T A user registered class, possibly const.
+      @param  L A Lua state.
+      @param  p A shared pointer to the user class instance.
+      @throws std::logic_error if the class is not registered.
+    */
+    template<class T>
+    static void push(lua_State* L, std::shared_ptr<T>&& p)
+    {
+        typedef typename std::remove_const<T>::type U;
+
+        if (!p)
+        {
+            lua_pushnil(L);
+            return;
+        }
+
+        // The table is looked up first so that a failure leaks no reference
+        pushRegistryTable(L,
+                          std::is_const<T>::value ? getConstRegistryKey<U>()
+                                                  : getClassRegistryKey<U>()); // Stack: rt
+        UserdataSharedPtr* const ud = new (lua_newuserdata(L, sizeof(UserdataSharedPtr)))
+            UserdataSharedPtr(std::const_pointer_cast<U>(std::move(p))); // Stack: rt, ud
+        lua_insert(L, -2); // Stack: ud, rt
+        setClassTable(L, ud); // Stack: ud
+    }
+
+    /**
+      Get a shared pointer to object from the Lua stack.
+
+      A Lua error is raised if the object is not the class or a subclass,
+      or if it is not owned by a shared pointer.
+
+      @tparam T     A user registered class, possibly const.
+      @param  L     A Lua state.
+      @param  index The index of an item on the Lua stack.
+      @returns A shared pointer, empty for nil.
+    */
+    template<class T>
+    static std::shared_ptr<T> get(lua_State* L, int index)
+    {
+        typedef typename std::remove_const<T>::type U;
+
+        T* const p = Userdata::get<U>(L, index, std::is_const<T>::value);
+        if (p == 0)
+        {
+            return std::shared_ptr<T>();
+        }
+
+        UserdataContainer* const ud = getContainer(L, index, &destroy);
+        if (ud == 0)
+        {
+            luaL_error(L, "The object is not owned by a shared pointer");
+        }
+        return std::shared_ptr<T>(static_cast<UserdataSharedPtr*>(ud)->m_sp, p);
+    }
+};
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+/**
+  Lua stack conversions for shared pointers to class objects.
+
+  The object lifetime is shared by C++ and Lua.
+*/
+template<class T>
+struct Stack<std::shared_ptr<T>>
+{
+    static void push(lua_State* L, std::shared_ptr<T> const& p)
+    {
+        detail::UserdataSharedPtr::push(L, std::shared_ptr<T>(p));
+    }
+
+    static void push(lua_State* L, std::shared_ptr<T>&& p)
+    {
+        detail::UserdataSharedPtr::push(L, std::move(p));
+    }
+
+    static std::shared_ptr<T> get(lua_State* L, int index)
+    {
+        return detail::UserdataSharedPtr::get<T>(L, index);
+    }
+
+    static bool isInstance(lua_State* L, int index)
+    {
+        return detail::Userdata::isInstance<typename std::remove_const<T>::type>(L, index);
+    }
+};
+
+//------------------------------------------------------------------------------
+/**
+  Lua stack conversions for unique pointers to class objects.
+
+  Pushing a unique pointer transfers the object ownership to Lua, the object
+  can be retrieved afterwards as a std::shared_ptr or a raw pointer.
+*/
+template<class T, class D>
+struct Stack<std::unique_ptr<T, D>>
+{
+    static void push(lua_State* L, std::unique_ptr<T, D>&& p)
+    {
+        detail::UserdataSharedPtr::push(L, std::shared_ptr<T>(std::move(p)));
+    }
+
+    static bool isInstance(lua_State* L, int index)
+    {
+        return detail::Userdata::isInstance<typename std::remove_const<T>::type>(L, index);
+    }
+};
+
+} // namespace luabridge
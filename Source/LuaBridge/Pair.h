@@ -6,7 +6,6 @@
 
 #include <LuaBridge/detail/Stack.h>
 
-#include <cassert>
 #include <utility>
 
 namespace luabridge {
@@ -17,12 +16,10 @@ struct Stack<std::pair<T1, T2>>
     static void push(lua_State* L, std::pair<T1, T2> const& pair)
     {
         lua_createtable(L, 2, 0);
-        lua_pushinteger(L, static_cast<lua_Integer>(1));
         Stack<T1>::push(L, pair.first);
-        lua_settable(L, -3);
-        lua_pushinteger(L, static_cast<lua_Integer>(2));
+        lua_rawseti(L, -2, 1);
         Stack<T2>::push(L, pair.second);
-        lua_settable(L, -3);
+        lua_rawseti(L, -2, 2);
     }
 
     static std::pair<T1, T2> get(lua_State* L, int index)
@@ -32,9 +29,7 @@ struct Stack<std::pair<T1, T2>>
             luaL_error(L, "#%d argument must be a table", index);
         }
 
-        std::size_t const tableSize = static_cast<std::size_t>(get_length(L, index));
-
-        if (tableSize != 2)
+        if (get_rawlength(L, index) != 2)
         {
             luaL_error(L, "pair size must be 2");
         }
@@ -42,38 +37,21 @@ struct Stack<std::pair<T1, T2>>
         std::pair<T1, T2> pair;
 
         int const absIndex = lua_absindex(L, index);
-        lua_pushnil(L);
-
-        {
-            int const hasNext = lua_next(L, lua_absindex(L, absIndex));
-            assert(hasNext != 0);
-            (void) hasNext;
-
-            pair.first = Stack<T1>::get(L, -1);
-            lua_pop(L, 1);
-        }
 
-        {
-            int const hasNext = lua_next(L, lua_absindex(L, absIndex));
-            assert(hasNext != 0);
-            (void) hasNext;
-
-            pair.second = Stack<T2>::get(L, -1);
-            lua_pop(L, 1);
-        }
+        lua_rawgeti(L, absIndex, 1);
+        pair.first = Stack<T1>::get(L, -1);
+        lua_pop(L, 1);
 
-        {
-            int const hasNext = lua_next(L, lua_absindex(L, absIndex));
-            assert(hasNext == 0);
-            (void) hasNext;
-        }
+        lua_rawgeti(L, absIndex, 2);
+        pair.second = Stack<T2>::get(L, -1);
+        lua_pop(L, 1);
 
         return pair;
     }
 
     static bool isInstance(lua_State* L, int index)
     {
-        return lua_istable(L, index) && get_length(L, index) == 2;
+        return lua_istable(L, index) && get_rawlength(L, index) == 2;
     }
 };
 
@@ -38,11 +38,307 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
 #include <utility>
 
 namespace luabridge {
 
+namespace detail {
+
+//==============================================================================
+/**
+  Operations on a reference counter.
+
+  A plain integer is incremented and decremented in place.
+*/
+template<class CounterType>
+struct RefCounter
+{
+    static void increment(CounterType& count) { ++count; }
+
+    static bool decrement(CounterType& count) { return --count == 0; }
+
+    static int get(CounterType const& count) { return static_cast<int>(count); }
+};
+
+/**
+  An atomic counter is incremented with a relaxed ordering, as taking a new
+  reference needs an existing one. The decrements use the acquire-release
+  ordering so that the last owner sees all the writes to the object before
+  deleting it.
+*/
+template<class T>
+struct RefCounter<std::atomic<T>>
+{
+    static void increment(std::atomic<T>& count) { count.fetch_add(1, std::memory_order_relaxed); }
+
+    static bool decrement(std::atomic<T>& count)
+    {
+        return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    static int get(std::atomic<T> const& count)
+    {
+        return static_cast<int>(count.load(std::memory_order_relaxed));
+    }
+};
+
+//==============================================================================
+/**
+  Free lists of memory blocks by size, kept for each thread.
+
+  Each thread keeps up to maxCached blocks of a size and moves the surplus
+  to a shared pool, from which the threads allocating the objects take them
+  back: the blocks freed by the thread releasing the objects are reused by
+  the one creating them. The shared pool keeps up to maxShared blocks of a
+  size and gives the others back to the heap. It is never destroyed, so that
+  the objects released after the free lists of their thread, like the
+  objects with static storage duration, still go to the pool.
+
+  The blocks larger than maxSize are left to the global heap.
+*/
+class FreeListPool
+{
+public:
+    static void* allocate(std::size_t size)
+    {
+        if (size > maxSize)
+        {
+            return ::operator new(size);
+        }
+
+        std::size_t const index = getIndex(size);
+        FreeLists* const local = getLocalFreeLists();
+        Block* block = nullptr;
+        if (local == nullptr)
+        {
+            SharedFreeLists& shared = getSharedFreeLists();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            block = shared.lists[index].pop();
+        }
+        else
+        {
+            FreeList& list = local->lists[index];
+            if (list.head == nullptr)
+            {
+                SharedFreeLists& shared = getSharedFreeLists();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                shared.lists[index].moveTo(list, batchSize);
+            }
+            block = list.pop();
+        }
+
+        return block != nullptr ? block : ::operator new((index + 1) * granularity);
+    }
+
+    static void deallocate(void* p, std::size_t size)
+    {
+        if (size > maxSize)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        std::size_t const index = getIndex(size);
+        Block* const block = static_cast<Block*>(p);
+        FreeLists* const local = getLocalFreeLists();
+        if (local == nullptr)
+        {
+            FreeList list;
+            list.push(block);
+            moveToShared(list, index, 1);
+            return;
+        }
+
+        FreeList& list = local->lists[index];
+        list.push(block);
+        if (list.count > maxCached)
+        {
+            moveToShared(list, index, batchSize);
+        }
+    }
+
+private:
+    static std::size_t const granularity = 16;
+    static std::size_t const maxSize = 256;
+    static std::size_t const maxCached = 64;
+    static std::size_t const maxShared = 1024;
+    static std::size_t const batchSize = 32;
+    static std::size_t const numLists = maxSize / granularity;
+
+    struct Block
+    {
+        Block* next;
+    };
+
+    struct FreeList
+    {
+        FreeList() : head(nullptr), count(0) {}
+
+        void push(Block* block)
+        {
+            block->next = head;
+            head = block;
+            ++count;
+        }
+
+        Block* pop()
+        {
+            Block* const block = head;
+            if (block != nullptr)
+            {
+                head = block->next;
+                --count;
+            }
+            return block;
+        }
+
+        void moveTo(FreeList& other, std::size_t n)
+        {
+            for (; n > 0 && head != nullptr; --n)
+            {
+                other.push(pop());
+            }
+        }
+
+        Block* head;
+        std::size_t count;
+    };
+
+    struct FreeLists
+    {
+        ~FreeLists()
+        {
+            isLocalDestroyed() = true;
+
+            for (std::size_t i = 0; i < numLists; ++i)
+            {
+                moveToShared(lists[i], i, lists[i].count);
+            }
+        }
+
+        FreeList lists[numLists];
+    };
+
+    struct SharedFreeLists
+    {
+        std::mutex mutex;
+        FreeList lists[numLists];
+    };
+
+    static std::size_t getIndex(std::size_t size) { return (size - 1) / granularity; }
+
+    /**
+      Move n blocks of a list to the shared pool, deleting those beyond its
+      capacity.
+    */
+    static void moveToShared(FreeList& list, std::size_t index, std::size_t n)
+    {
+        {
+            SharedFreeLists& shared = getSharedFreeLists();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            FreeList& sharedList = shared.lists[index];
+            std::size_t const room =
+                sharedList.count < maxShared ? maxShared - sharedList.count : 0;
+            std::size_t const moved = n < room ? n : room;
+            list.moveTo(sharedList, moved);
+            n -= moved;
+        }
+
+        for (; n > 0 && list.head != nullptr; --n)
+        {
+            ::operator delete(list.pop());
+        }
+    }
+
+    static bool& isLocalDestroyed()
+    {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    /**
+      Get the free lists of the calling thread, or a null pointer once they
+      are destroyed.
+    */
+    static FreeLists* getLocalFreeLists()
+    {
+        if (isLocalDestroyed())
+        {
+            return nullptr;
+        }
+
+        static thread_local FreeLists freeLists;
+        return &freeLists;
+    }
+
+    static SharedFreeLists& getSharedFreeLists()
+    {
+        static SharedFreeLists* const sharedFreeLists = new SharedFreeLists;
+        return *sharedFreeLists;
+    }
+};
+
+} // namespace detail
+
+//==============================================================================
+/**
+  Deletion policies of RefCountedObjectType.
+
+  The object deleted by its last reference is released by its class
+  operator delete, which the policy provides along with operator new.
+*/
+
+/**
+  The objects are allocated from and deleted to the global heap.
+*/
+struct HeapDelete
+{
+};
+
+/**
+  The memory of the deleted objects is kept in per-thread free lists, and
+  reused by the next objects of the same size, typically of the same type.
+  The surplus of a thread goes to a pool shared by all threads, so the
+  objects may be released by another thread than the one creating them.
+
+  The objects must be created with new to come from the pool. The pools
+  are kept by size, shared by the classes of the same size. The memory of
+  the cached blocks is not given back to the heap. The over-aligned classes
+  are allocated from the heap.
+*/
+struct PooledDelete
+{
+    static void* operator new(std::size_t size) { return detail::FreeListPool::allocate(size); }
+
+    static void operator delete(void* p, std::size_t size)
+    {
+        detail::FreeListPool::deallocate(p, size);
+    }
+
+    // The class operator new hides the global placement new, used for the
+    // objects living inside userdata.
+    static void* operator new(std::size_t, void* p) noexcept { return p; }
+
+    static void operator delete(void*, void*) noexcept {}
+
+#ifdef __cpp_aligned_new
+    static void* operator new(std::size_t size, std::align_val_t alignment)
+    {
+        return ::operator new(size, alignment);
+    }
+
+    static void operator delete(void* p, std::size_t size, std::align_val_t alignment)
+    {
+        ::operator delete(p, size, alignment);
+    }
+#endif // __cpp_aligned_new
+};
+
 //==============================================================================
 /**
   Adds reference-counting to an object.
@@ -68,9 +364,13 @@ namespace luabridge {
 
   Once a new RefCountedObjectType has been assigned to a pointer, be
   careful not to delete the object manually.
+
+  @tparam CounterType  The counter type: int, or std::atomic<int> for the
+                       objects shared between threads.
+  @tparam DeletePolicy The deletion policy: HeapDelete or PooledDelete.
 */
-template<class CounterType>
-class RefCountedObjectType
+template<class CounterType, class DeletePolicy = HeapDelete>
+class RefCountedObjectType : public DeletePolicy
 {
 public:
     //==============================================================================
@@ -79,7 +379,7 @@ public:
         This is done automatically by the smart pointer, but is public just
         in case it's needed for nefarious purposes.
     */
-    void incReferenceCount() const { ++refCount; }
+    void incReferenceCount() const { detail::RefCounter<CounterType>::increment(refCount); }
 
     /** Decreases the object's reference count.
 
@@ -89,14 +389,14 @@ public:
     {
         assert(getReferenceCount() > 0);
 
-        if (--refCount == 0)
+        if (detail::RefCounter<CounterType>::decrement(refCount))
             delete this;
     }
 
     /** Returns the object's current reference count.
      * @returns The reference count.
      */
-    int getReferenceCount() const { return static_cast<int>(refCount); }
+    int getReferenceCount() const { return detail::RefCounter<CounterType>::get(refCount); }
 
 protected:
     //==============================================================================
@@ -124,6 +424,13 @@ private:
 */
 typedef RefCountedObjectType<int> RefCountedObject;
 
+/** Thread-safe reference counted object.
+
+    This creates a RefCountedObjectType that uses an atomic integer as the
+    counter.
+*/
+typedef RefCountedObjectType<std::atomic<int>> AtomicRefCountedObject;
+
 //==============================================================================
 /**
     A smart-pointer class which points to a reference-counted object.
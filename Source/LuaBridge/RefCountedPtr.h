@@ -8,6 +8,9 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 
@@ -25,15 +28,140 @@ struct RefCountedPtrBase
     typedef std::unordered_map<const void*, int> RefCountsType;
 
 protected:
-    RefCountsType& getRefCounts() const
+    static RefCountsType& getRefCounts()
     {
         static RefCountsType refcounts;
         return refcounts;
     }
+
+    static void addRef(RefCountsType& refcounts, const void* p) { ++refcounts[p]; }
+
+    static bool release(RefCountsType& refcounts, const void* p)
+    {
+        const auto itCounter = refcounts.find(p);
+        assert(itCounter != refcounts.end());
+        assert(itCounter->second > 0);
+
+        if (--itCounter->second != 0)
+        {
+            return false;
+        }
+
+        refcounts.erase(itCounter);
+        return true;
+    }
+
+    static int count(RefCountsType const& refcounts, const void* p)
+    {
+        const auto itCounter = refcounts.find(p);
+        assert(itCounter != refcounts.end());
+        assert(itCounter->second > 0);
+
+        return itCounter->second;
+    }
 };
 
 } // namespace detail
 
+//==============================================================================
+/**
+  Reference count policies of RefCountedPtr.
+
+  A policy provides the static functions addRef(), release(), which returns
+  true when the last reference is released, and count().
+*/
+
+/**
+  The counts of all the objects are kept in a single hash table.
+
+  This is the default policy. It is not thread-safe.
+*/
+struct GlobalRefCounts : private detail::RefCountedPtrBase
+{
+    static void addRef(const void* p) { RefCountedPtrBase::addRef(getRefCounts(), p); }
+
+    static bool release(const void* p) { return RefCountedPtrBase::release(getRefCounts(), p); }
+
+    static int count(const void* p) { return RefCountedPtrBase::count(getRefCounts(), p); }
+};
+
+/**
+  The counts are spread over hash tables each guarded by its own mutex.
+
+  The objects can be shared between threads, and the threads updating the
+  counts of different objects rarely wait for each other.
+*/
+class ShardedRefCounts : private detail::RefCountedPtrBase
+{
+public:
+    static void addRef(const void* p)
+    {
+        Shard& shard = getShard(p);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        RefCountedPtrBase::addRef(shard.refcounts, p);
+    }
+
+    static bool release(const void* p)
+    {
+        Shard& shard = getShard(p);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return RefCountedPtrBase::release(shard.refcounts, p);
+    }
+
+    static int count(const void* p)
+    {
+        Shard& shard = getShard(p);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return RefCountedPtrBase::count(shard.refcounts, p);
+    }
+
+private:
+    static std::size_t const shardCount = 64;
+
+    // Aligned to a cache line, so that the threads locking neighbour shards
+    // do not contend
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        RefCountsType refcounts;
+    };
+
+    static Shard& getShard(const void* p)
+    {
+        static Shard shards[shardCount];
+
+        // The low bits of an object address are mostly zero
+        std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(p);
+        return shards[((address >> 4) ^ (address >> 12)) % shardCount];
+    }
+};
+
+/**
+  The counts are kept in a hash table of the current thread.
+
+  This fits the programs running each Lua state in its own thread: no lock
+  is taken, but all the references to an object must be created and released
+  by the same thread.
+*/
+struct ThreadLocalRefCounts : private detail::RefCountedPtrBase
+{
+    static void addRef(const void* p) { RefCountedPtrBase::addRef(getThreadRefCounts(), p); }
+
+    static bool release(const void* p)
+    {
+        return RefCountedPtrBase::release(getThreadRefCounts(), p);
+    }
+
+    static int count(const void* p) { return RefCountedPtrBase::count(getThreadRefCounts(), p); }
+
+private:
+    static RefCountsType& getThreadRefCounts()
+    {
+        static thread_local RefCountsType refcounts;
+        return refcounts;
+    }
+};
+
 //==============================================================================
 /**
   A reference counted smart pointer.
@@ -42,25 +170,26 @@ protected:
   sense that it implements a strict subset of the functionality.
 
   This implementation uses a hash table to look up the reference count
-  associated with a particular pointer.
+  associated with a particular pointer. Where the table is kept is decided
+  by the reference count policy.
 
-  @tparam T The class type.
+  @tparam T         The class type.
+  @tparam RefCounts The reference count policy: GlobalRefCounts,
+                    ShardedRefCounts or ThreadLocalRefCounts.
 
-  @todo Decompose RefCountedPtr using a policy. At a minimum, the underlying
-        reference count should be policy based (to support atomic operations)
-        and the delete behavior should be policy based (to support custom
+  @todo The delete behavior should be policy based (to support custom
         disposal methods).
 
   @todo Provide an intrusive version of RefCountedPtr.
 */
-template<class T>
-class RefCountedPtr : private detail::RefCountedPtrBase
+template<class T, class RefCounts = GlobalRefCounts>
+class RefCountedPtr
 {
 public:
     template<typename Other>
     struct rebind
     {
-        typedef RefCountedPtr<Other> other;
+        typedef RefCountedPtr<Other, RefCounts> other;
     };
 
     /** Construct as nullptr or from existing pointer to T.
@@ -71,7 +200,7 @@ public:
     {
         if (m_p)
         {
-            ++getRefCounts()[m_p];
+            RefCounts::addRef(m_p);
         }
     }
 
@@ -79,7 +208,7 @@ public:
 
         @param rhs The RefCountedPtr to assign from.
     */
-    RefCountedPtr(RefCountedPtr<T> const& rhs) : RefCountedPtr(rhs.get()) {}
+    RefCountedPtr(RefCountedPtr<T, RefCounts> const& rhs) : RefCountedPtr(rhs.get()) {}
 
     /** Construct from a RefCountedPtr of a different type.
 
@@ -89,7 +218,7 @@ public:
         @param  rhs The RefCountedPtr to assign from.
     */
     template<typename U>
-    RefCountedPtr(RefCountedPtr<U> const& rhs) : RefCountedPtr(rhs.get())
+    RefCountedPtr(RefCountedPtr<U, RefCounts> const& rhs) : RefCountedPtr(rhs.get())
     {
     }
 
@@ -104,7 +233,7 @@ public:
         @param  rhs The RefCountedPtr to assign from.
         @returns     A reference to the RefCountedPtr.
     */
-    RefCountedPtr<T>& operator=(RefCountedPtr<T> const& rhs)
+    RefCountedPtr<T, RefCounts>& operator=(RefCountedPtr<T, RefCounts> const& rhs)
     {
         // NOTE Self assignment is handled gracefully
         *this = rhs.get();
@@ -120,18 +249,18 @@ public:
         @returns     A reference to the RefCountedPtr.
     */
     template<typename U>
-    RefCountedPtr<T>& operator=(RefCountedPtr<U> const& rhs)
+    RefCountedPtr<T, RefCounts>& operator=(RefCountedPtr<U, RefCounts> const& rhs)
     {
         // NOTE Self assignment is handled gracefully
         *this = rhs.get();
         return *this;
     }
 
-    RefCountedPtr<T>& operator=(T* const p)
+    RefCountedPtr<T, RefCounts>& operator=(T* const p)
     {
         if (p != m_p)
         {
-            RefCountedPtr<T> tmp(p);
+            RefCountedPtr<T, RefCounts> tmp(p);
             std::swap(m_p, tmp.m_p);
         }
 
@@ -164,22 +293,18 @@ public:
 
     /** Determine the number of references.
 
-        @note This is not thread-safe.
+        @note This is not thread-safe with the default policy.
 
         @returns The number of active references.
     */
-    RefCountsType::mapped_type use_count() const
+    int use_count() const
     {
         if (!m_p)
         {
             return 0;
         }
 
-        const auto itCounter = getRefCounts().find(m_p);
-        assert(itCounter != getRefCounts().end());
-        assert(itCounter->second > 0);
-
-        return itCounter->second;
+        return RefCounts::count(m_p);
     }
 
     /** Release the pointer.
@@ -191,14 +316,9 @@ public:
     {
         if (m_p)
         {
-            const auto itCounter = getRefCounts().find(m_p);
-            assert(itCounter != getRefCounts().end());
-            assert(itCounter->second > 0);
-
-            if (--itCounter->second == 0)
+            if (RefCounts::release(m_p))
             {
                 delete m_p;
-                getRefCounts().erase(itCounter);
             }
 
             m_p = nullptr;
@@ -215,12 +335,12 @@ private:
 template<class T>
 struct ContainerTraits;
 
-template<class T>
-struct ContainerTraits<RefCountedPtr<T>>
+template<class T, class RefCounts>
+struct ContainerTraits<RefCountedPtr<T, RefCounts>>
 {
     typedef T Type;
 
-    static T* get(RefCountedPtr<T> const& c) { return c.get(); }
+    static T* get(RefCountedPtr<T, RefCounts> const& c) { return c.get(); }
 };
 
 } // namespace luabridge
@@ -18,9 +18,8 @@ struct Stack<std::vector<T>>
         lua_createtable(L, static_cast<int>(vector.size()), 0);
         for (std::size_t i = 0; i < vector.size(); ++i)
         {
-            lua_pushinteger(L, static_cast<lua_Integer>(i + 1));
             Stack<T>::push(L, vector[i]);
-            lua_settable(L, -3);
+            lua_rawseti(L, -2, static_cast<int>(i + 1));
         }
     }
 
@@ -31,13 +30,15 @@ struct Stack<std::vector<T>>
             luaL_error(L, "#%d argument must be a table", index);
         }
 
+        int const size = get_rawlength(L, index);
+
         std::vector<T> vector;
-        vector.reserve(static_cast<std::size_t>(get_length(L, index)));
+        vector.reserve(static_cast<std::size_t>(size));
 
         int const absindex = lua_absindex(L, index);
-        lua_pushnil(L);
-        while (lua_next(L, absindex) != 0)
+        for (int i = 1; i <= size; ++i)
         {
+            lua_rawgeti(L, absindex, i);
             vector.push_back(Stack<T>::get(L, -1));
             lua_pop(L, 1);
         }
@@ -8,12 +8,159 @@
 #include <LuaBridge/detail/Config.h>
 #include <LuaBridge/detail/FuncTraits.h>
 
+#include <cstddef>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace luabridge {
 
 namespace detail {
 
+/**
+    Trait telling whether a member function or a proxy function can be
+    called on a const object.
+*/
+template<class FnPtr>
+struct IsConstCallable
+{
+    static bool const value = false;
+};
+
+template<class T, class R, class... ParamList>
+struct IsConstCallable<R (T::*)(ParamList...) const>
+{
+    static bool const value = true;
+};
+
+template<class T, class R, class... ParamList>
+struct IsConstCallable<R (*)(T const*, ParamList...)>
+{
+    static bool const value = true;
+};
+
+//==============================================================================
+/**
+    A class property getter or setter stored in a propget or propset table.
+
+    The __index and __newindex metamethods call it in place instead of
+    calling a closure with lua_call. The stack is the same as for a getter
+    or setter closure: the object is at the index 1 and the new value of a
+    setter at the index 2.
+*/
+struct PropertyAccessor
+{
+    typedef int (*Function)(lua_State* L, PropertyAccessor const& accessor);
+
+    explicit PropertyAccessor(Function function) : function(function) {}
+
+    Function const function;
+};
+
+/**
+    A property accessor with the function pointer or the member pointer it
+    calls.
+*/
+template<class Data>
+struct PropertyAccessorOf : PropertyAccessor
+{
+    PropertyAccessorOf(Function function, Data const& data) : PropertyAccessor(function), data(data)
+    {
+    }
+
+    Data const data;
+};
+
+//------------------------------------------------------------------------------
+/**
+    The type tag of a data member read and written through its offset.
+
+    Only the arithmetic types with a library Stack specialization have a
+    tag, the enums and the other types use a member pointer accessor.
+*/
+template<class T>
+struct FieldType
+{
+    static bool const isSupported = false;
+};
+
+#define LUABRIDGE_FIELD_TYPE(T, tag)                                                               \
+    template<>                                                                                     \
+    struct FieldType<T>                                                                            \
+    {                                                                                              \
+        static bool const isSupported = true;                                                      \
+        static unsigned char const value = tag;                                                    \
+    }
+
+LUABRIDGE_FIELD_TYPE(bool, 0);
+LUABRIDGE_FIELD_TYPE(char, 1);
+LUABRIDGE_FIELD_TYPE(unsigned char, 2);
+LUABRIDGE_FIELD_TYPE(short, 3);
+LUABRIDGE_FIELD_TYPE(unsigned short, 4);
+LUABRIDGE_FIELD_TYPE(int, 5);
+LUABRIDGE_FIELD_TYPE(unsigned int, 6);
+LUABRIDGE_FIELD_TYPE(long, 7);
+LUABRIDGE_FIELD_TYPE(unsigned long, 8);
+LUABRIDGE_FIELD_TYPE(long long, 9);
+LUABRIDGE_FIELD_TYPE(unsigned long long, 10);
+LUABRIDGE_FIELD_TYPE(float, 11);
+LUABRIDGE_FIELD_TYPE(double, 12);
+
+#undef LUABRIDGE_FIELD_TYPE
+
+/**
+    Trait telling whether a data member can be accessed through its offset.
+*/
+template<class C, class T>
+struct IsOffsetField
+{
+    static bool const value = std::is_standard_layout<C>::value && FieldType<T>::isSupported;
+};
+
+/**
+    A data member of a standard-layout class, read and written through its
+    byte offset and type tag.
+
+    All such members share a single accessor function, which reads the
+    value when the object is alone on the stack and writes it otherwise.
+    One accessor is stored in both the propget and propset tables.
+*/
+struct FieldAccessor : PropertyAccessor
+{
+    FieldAccessor(Function function,
+                  void const* registryConstKey,
+                  void const* registryClassKey,
+                  int classId,
+                  std::size_t offset,
+                  unsigned char type)
+        : PropertyAccessor(function)
+        , registryConstKey(registryConstKey)
+        , registryClassKey(registryClassKey)
+        , classId(classId)
+        , offset(offset)
+        , type(type)
+    {
+    }
+
+    /**
+        Get the byte offset of a data member.
+    */
+    template<class C, class T>
+    static std::size_t offsetOf(T C::*mp)
+    {
+        typename std::aligned_storage<sizeof(C), alignof(C)>::type storage;
+        C const* const object = reinterpret_cast<C const*>(&storage);
+        return static_cast<std::size_t>(reinterpret_cast<char const*>(&(object->*mp)) -
+                                        reinterpret_cast<char const*>(object));
+    }
+
+    void const* const registryConstKey;
+    void const* const registryClassKey;
+    int const classId;
+    std::size_t const offset;
+    unsigned char const type;
+};
+
 // We use a structure so we can define everything in the header.
 //
 struct CFunc
@@ -21,7 +168,7 @@ struct CFunc
     static void addGetter(lua_State* L, const char* name, int tableIndex)
     {
         assert(lua_istable(L, tableIndex));
-        assert(lua_iscfunction(L, -1)); // Stack: getter
+        assert(lua_iscfunction(L, -1) || lua_isuserdata(L, -1)); // Stack: getter
 
         lua_rawgetp(L, tableIndex, getPropgetKey()); // Stack: getter, propget table (pg)
         lua_pushvalue(L, -2); // Stack: getter, pg, getter
@@ -29,10 +176,35 @@ struct CFunc
         lua_pop(L, 2); // Stack: -
     }
 
+    /**
+        Add a getter to the propget tables of two tables, typically the const
+        and class ones, pushing the name once.
+    */
+    static void addGetter(lua_State* L, const char* name, int tableIndex1, int tableIndex2)
+    {
+        assert(lua_istable(L, tableIndex1));
+        assert(lua_istable(L, tableIndex2));
+        assert(lua_iscfunction(L, -1) || lua_isuserdata(L, -1)); // Stack: getter
+
+        tableIndex1 = lua_absindex(L, tableIndex1);
+        tableIndex2 = lua_absindex(L, tableIndex2);
+        lua_pushstring(L, name); // Stack: getter, name
+        lua_rawgetp(L, tableIndex1, getPropgetKey()); // Stack: getter, name, pg1
+        lua_pushvalue(L, -2); // Stack: getter, name, pg1, name
+        lua_pushvalue(L, -4); // Stack: getter, name, pg1, name, getter
+        lua_rawset(L, -3); // Stack: getter, name, pg1
+        lua_pop(L, 1); // Stack: getter, name
+        lua_rawgetp(L, tableIndex2, getPropgetKey()); // Stack: getter, name, pg2
+        lua_insert(L, -3); // Stack: pg2, getter, name
+        lua_insert(L, -2); // Stack: pg2, name, getter
+        lua_rawset(L, -3); // Stack: pg2
+        lua_pop(L, 1); // Stack: -
+    }
+
     static void addSetter(lua_State* L, const char* name, int tableIndex)
     {
         assert(lua_istable(L, tableIndex));
-        assert(lua_iscfunction(L, -1)); // Stack: setter
+        assert(lua_iscfunction(L, -1) || lua_isuserdata(L, -1)); // Stack: setter
 
         lua_rawgetp(L, tableIndex, getPropsetKey()); // Stack: setter, propset table (ps)
         lua_pushvalue(L, -2); // Stack: setter, ps, setter
@@ -83,6 +255,15 @@ struct CFunc
                 return 1;
             }
 
+            if (lua_isuserdata(L, -1)) // Stack: mt, getter
+            {
+                // The getter stays referenced by the propget table
+                PropertyAccessor const* const getter =
+                    static_cast<PropertyAccessor const*>(lua_touserdata(L, -1));
+                lua_settop(L, 1); // Stack: table | userdata
+                return getter->function(L, *getter); // Stack: table | userdata, value
+            }
+
             assert(lua_isnil(L, -1)); // Stack: mt, nil
             lua_pop(L, 1); // Stack: mt
 
@@ -164,6 +345,18 @@ struct CFunc
                 return 0;
             }
 
+            if (lua_isuserdata(L, -1)) // Stack: mt, setter
+            {
+                assert(pushSelf);
+
+                // The setter stays referenced by the propset table
+                PropertyAccessor const* const setter =
+                    static_cast<PropertyAccessor const*>(lua_touserdata(L, -1));
+                lua_settop(L, 3); // Stack: table | userdata, name, new value
+                lua_remove(L, 2); // Stack: table | userdata, new value
+                return setter->function(L, *setter);
+            }
+
             assert(lua_isnil(L, -1)); // Stack: mt, nil
             lua_pop(L, 1); // Stack: mt
 
@@ -239,7 +432,7 @@ struct CFunc
 
         The function pointer (lightuserdata) in the first upvalue.
     */
-    template<class FnPtr>
+    template<class FnPtr, bool isChecked = checkedCalls>
     struct Call
     {
         typedef typename FuncTraits<FnPtr>::Params Params;
@@ -250,7 +443,12 @@ struct CFunc
             assert(lua_islightuserdata(L, lua_upvalueindex(1)));
             FnPtr fnptr = reinterpret_cast<FnPtr>(lua_touserdata(L, lua_upvalueindex(1)));
             assert(fnptr != 0);
-            return Invoke<ReturnType, Params, 1>::run(L, fnptr);
+            return call(L, fnptr);
+        }
+
+        static int call(lua_State* L, FnPtr fnptr)
+        {
+            return Invoke<ReturnType, Params, 1, isChecked>::run(L, fnptr);
         }
     };
 
@@ -261,7 +459,7 @@ struct CFunc
         The member function pointer is in the first upvalue.
         The class userdata object is at the top of the Lua stack.
     */
-    template<class MemFnPtr>
+    template<class MemFnPtr, bool isChecked = checkedCalls>
     struct CallMember
     {
         typedef typename FuncTraits<MemFnPtr>::ClassType T;
@@ -271,15 +469,21 @@ struct CFunc
         static int f(lua_State* L)
         {
             assert(isfulluserdata(L, lua_upvalueindex(1)));
-            T* const t = Userdata::get<T>(L, 1, false);
             MemFnPtr const& fnptr =
                 *static_cast<MemFnPtr const*>(lua_touserdata(L, lua_upvalueindex(1)));
             assert(fnptr != 0);
-            return Invoke<ReturnType, Params, 2>::run(L, t, fnptr);
+            return call(L, fnptr);
+        }
+
+        static int call(lua_State* L, MemFnPtr const& fnptr)
+        {
+            T* const t = isChecked ? Userdata::get<T>(L, 1, false)
+                                   : Userdata::getUnchecked<T>(L, 1, false);
+            return Invoke<ReturnType, Params, 2, isChecked>::run(L, t, fnptr);
         }
     };
 
-    template<class MemFnPtr>
+    template<class MemFnPtr, bool isChecked = checkedCalls>
     struct CallConstMember
     {
         typedef typename FuncTraits<MemFnPtr>::ClassType T;
@@ -289,11 +493,17 @@ struct CFunc
         static int f(lua_State* L)
         {
             assert(isfulluserdata(L, lua_upvalueindex(1)));
-            T const* const t = Userdata::get<T>(L, 1, true);
             MemFnPtr const& fnptr =
                 *static_cast<MemFnPtr const*>(lua_touserdata(L, lua_upvalueindex(1)));
             assert(fnptr != 0);
-            return Invoke<ReturnType, Params, 2>::run(L, t, fnptr);
+            return call(L, fnptr);
+        }
+
+        static int call(lua_State* L, MemFnPtr const& fnptr)
+        {
+            T const* const t = isChecked ? Userdata::get<T>(L, 1, true)
+                                         : Userdata::getUnchecked<T>(L, 1, true);
+            return Invoke<ReturnType, Params, 2, isChecked>::run(L, t, fnptr);
         }
     };
 
@@ -339,7 +549,7 @@ struct CFunc
         The proxy function pointer (lightuserdata) is in the first upvalue.
         The class userdata object is at the top of the Lua stack.
     */
-    template<class FnPtr>
+    template<class FnPtr, bool isChecked = checkedCalls>
     struct CallProxyFunction
     {
         using Params = typename FuncTraits<FnPtr>::Params;
@@ -350,7 +560,7 @@ struct CFunc
             assert(lua_islightuserdata(L, lua_upvalueindex(1)));
             auto fnptr = reinterpret_cast<FnPtr>(lua_touserdata(L, lua_upvalueindex(1)));
             assert(fnptr != 0);
-            return Invoke<ReturnType, Params, 1>::run(L, fnptr);
+            return Invoke<ReturnType, Params, 1, isChecked>::run(L, fnptr);
         }
     };
 
@@ -368,30 +578,113 @@ struct CFunc
         }
     };
 
+    //--------------------------------------------------------------------------
+    /**
+        Push a C closure calling a function object.
+
+        The function object is moved into a userdata upvalue of the closure,
+        its __gc metamethod destroys it.
+    */
+    template<class Functor>
+    static void pushFunctor(lua_State* L, Functor functor)
+    {
+        new (lua_newuserdata(L, sizeof(Functor))) Functor(std::move(functor)); // Stack: ud
+        lua_newtable(L); // Stack: ud, ud metatable (mt)
+        lua_pushcfunction(L, &gcMetaMethodAny<Functor>); // Stack: ud, mt, gc function
+        rawsetfield(L, -2, "__gc"); // Stack: ud, mt
+        lua_setmetatable(L, -2); // Stack: ud
+        lua_pushcclosure(L, &CallProxyFunctor<Functor>::f, 1); // Stack: function
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+        lua_CFunction to call a function known at compile time.
+
+        This is used for global functions, class static methods and proxy
+        functions. The function has no upvalue.
+    */
+    template<class FnPtr,
+             FnPtr fnptr,
+             bool isChecked = checkedCalls,
+             bool isMember = FuncTraits<FnPtr>::isMemberFunction>
+    struct CallBound
+    {
+        typedef typename FuncTraits<FnPtr>::Params Params;
+        typedef typename FuncTraits<FnPtr>::ReturnType ReturnType;
+
+        static int f(lua_State* L)
+        {
+            FnPtr fn = fnptr;
+            return Invoke<ReturnType, Params, 1, isChecked>::run(L, fn);
+        }
+    };
+
+    /**
+        lua_CFunction to call a class member function known at compile time.
+
+        The class userdata object is at the top of the Lua stack.
+        The function has no upvalue.
+    */
+    template<class MemFnPtr, MemFnPtr fnptr, bool isChecked>
+    struct CallBound<MemFnPtr, fnptr, isChecked, true>
+    {
+        typedef typename FuncTraits<MemFnPtr>::ClassType T;
+        typedef typename FuncTraits<MemFnPtr>::Params Params;
+        typedef typename FuncTraits<MemFnPtr>::ReturnType ReturnType;
+
+        static int f(lua_State* L)
+        {
+            bool const canBeConst = FuncTraits<MemFnPtr>::isConstMemberFunction;
+            T* const t = isChecked ? Userdata::get<T>(L, 1, canBeConst)
+                                   : Userdata::getUnchecked<T>(L, 1, canBeConst);
+            return Invoke<ReturnType, Params, 2, isChecked>::run(L, t, fnptr);
+        }
+    };
+
     //--------------------------------------------------------------------------
 
     // SFINAE Helpers
 
-    template<class MemFnPtr, bool isConst>
+    template<class MemFnPtr, bool isConst, bool isChecked = checkedCalls>
     struct CallMemberFunctionHelper
     {
         static void add(lua_State* L, char const* name, MemFnPtr mf)
         {
             new (lua_newuserdata(L, sizeof(MemFnPtr))) MemFnPtr(mf);
-            lua_pushcclosure(L, &CallConstMember<MemFnPtr>::f, 1);
-            lua_pushvalue(L, -1);
-            rawsetfield(L, -5, name); // const table
-            rawsetfield(L, -3, name); // class table
+            lua_pushcclosure(L, &CallConstMember<MemFnPtr, isChecked>::f, 1);
+            rawsetfield(L, -4, -3, name); // const and class tables
         }
     };
 
-    template<class MemFnPtr>
-    struct CallMemberFunctionHelper<MemFnPtr, false>
+    template<class MemFnPtr, bool isChecked>
+    struct CallMemberFunctionHelper<MemFnPtr, false, isChecked>
     {
         static void add(lua_State* L, char const* name, MemFnPtr mf)
         {
             new (lua_newuserdata(L, sizeof(MemFnPtr))) MemFnPtr(mf);
-            lua_pushcclosure(L, &CallMember<MemFnPtr>::f, 1);
+            lua_pushcclosure(L, &CallMember<MemFnPtr, isChecked>::f, 1);
+            rawsetfield(L, -3, name); // class table
+        }
+    };
+
+    template<class FnPtr, FnPtr fnptr, bool isConst, bool isChecked = checkedCalls>
+    struct CallBoundFunctionHelper
+    {
+        static void add(lua_State* L, char const* name)
+        {
+            typedef CallBound<FnPtr, fnptr, isChecked> Thunk;
+            lua_pushcfunction(L, &Thunk::f);
+            rawsetfield(L, -4, -3, name); // const and class tables
+        }
+    };
+
+    template<class FnPtr, FnPtr fnptr, bool isChecked>
+    struct CallBoundFunctionHelper<FnPtr, fnptr, false, isChecked>
+    {
+        static void add(lua_State* L, char const* name)
+        {
+            typedef CallBound<FnPtr, fnptr, isChecked> Thunk;
+            lua_pushcfunction(L, &Thunk::f);
             rawsetfield(L, -3, name); // class table
         }
     };
@@ -404,7 +697,7 @@ struct CFunc
     static int gcMetaMethod(lua_State* L)
     {
         Userdata* const ud = Userdata::getExact<C>(L, 1);
-        ud->~Userdata();
+        Userdata::destroy<C>(ud);
         return 0;
     }
 
@@ -422,47 +715,160 @@ struct CFunc
 
     //--------------------------------------------------------------------------
     /**
-        lua_CFunction to get a class data member.
+        Get a class data member.
 
-        The pointer-to-member is in the first upvalue.
         The class userdata object is at the top of the Lua stack.
     */
-    template<class C, typename T>
-    static int getProperty(lua_State* L)
+    template<class C, typename T, bool isChecked = checkedCalls>
+    struct GetProperty
     {
-        C* const c = Userdata::get<C>(L, 1, true);
-        T C::** mp = static_cast<T C::**>(lua_touserdata(L, lua_upvalueindex(1)));
-        try
+        static int call(lua_State* L, T C::*mp)
         {
-            Stack<T&>::push(L, c->**mp);
+            C* const c = isChecked ? Userdata::get<C>(L, 1, true)
+                                   : Userdata::getUnchecked<C>(L, 1, true);
+            try
+            {
+                Stack<T&>::push(L, c->*mp);
+            }
+            catch (const std::exception& e)
+            {
+                luaL_error(L, e.what());
+            }
+            return 1;
         }
-        catch (const std::exception& e)
+    };
+
+    //--------------------------------------------------------------------------
+    /**
+        Set a class data member.
+
+        The class userdata object is at the top of the Lua stack.
+    */
+    template<class C, typename T, bool isChecked = checkedCalls>
+    struct SetProperty
+    {
+        static int call(lua_State* L, T C::*mp)
         {
-            luaL_error(L, e.what());
+            C* const c = isChecked ? Userdata::get<C>(L, 1, false)
+                                   : Userdata::getUnchecked<C>(L, 1, false);
+            try
+            {
+                c->*mp = ArgGetter<T, isChecked>::get(L, 2);
+            }
+            catch (const std::exception& e)
+            {
+                luaL_error(L, e.what());
+            }
+            return 0;
         }
-        return 1;
+    };
+
+    //--------------------------------------------------------------------------
+    /**
+        Push a property accessor calling Caller::call() with the data.
+
+        @tparam Caller A structure with a static call(lua_State*, Data) function.
+        @param  L      A Lua state.
+        @param  data   The function pointer or the member pointer to call.
+    */
+    template<class Caller, class Data>
+    static void pushPropertyAccessor(lua_State* L, Data const& data)
+    {
+        new (lua_newuserdata(L, sizeof(PropertyAccessorOf<Data>)))
+            PropertyAccessorOf<Data>(&callPropertyAccessor<Caller, Data>, data);
+    }
+
+    template<class Caller, class Data>
+    static int callPropertyAccessor(lua_State* L, PropertyAccessor const& accessor)
+    {
+        return Caller::call(L, static_cast<PropertyAccessorOf<Data> const&>(accessor).data);
     }
 
     //--------------------------------------------------------------------------
     /**
-        lua_CFunction to set a class data member.
+        Push the offset accessor of a data member.
 
-        The pointer-to-member is in the first upvalue.
-        The class userdata object is at the top of the Lua stack.
+        @param L  A Lua state.
+        @param mp The data member of a standard-layout class.
+    */
+    template<class C, class T>
+    static void pushFieldAccessor(lua_State* L, T C::*mp)
+    {
+        static_assert(IsOffsetField<C, T>::value, "Unsupported data member type");
+
+        new (lua_newuserdata(L, sizeof(FieldAccessor))) FieldAccessor(&callFieldAccessor,
+                                                                      getConstRegistryKey<C>(),
+                                                                      getClassRegistryKey<C>(),
+                                                                      getClassId<C>(),
+                                                                      FieldAccessor::offsetOf(mp),
+                                                                      FieldType<T>::value);
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+        Read or write a data member through its offset accessor.
+
+        The class userdata object is at the index 1 and the new value, if any,
+        at the index 2.
     */
-    template<class C, typename T>
-    static int setProperty(lua_State* L)
+    static int callFieldAccessor(lua_State* L, PropertyAccessor const& accessor)
     {
-        C* const c = Userdata::get<C>(L, 1, false);
-        T C::** mp = static_cast<T C::**>(lua_touserdata(L, lua_upvalueindex(1)));
-        try
+        FieldAccessor const& field = static_cast<FieldAccessor const&>(accessor);
+        bool const isGet = lua_gettop(L) == 1;
+        char* const object = static_cast<char*>(
+            checkedCalls ? Userdata::getUntyped(L,
+                                                1,
+                                                field.registryConstKey,
+                                                field.registryClassKey,
+                                                field.classId,
+                                                isGet)
+                         : Userdata::getUncheckedUntyped(L, 1, field.classId, isGet));
+        void* const p = object + field.offset;
+
+        switch (field.type)
         {
-            c->** mp = Stack<T>::get(L, 2);
+        case FieldType<bool>::value:
+            return accessField(L, static_cast<bool*>(p), isGet);
+        case FieldType<char>::value:
+            return accessField(L, static_cast<char*>(p), isGet);
+        case FieldType<unsigned char>::value:
+            return accessField(L, static_cast<unsigned char*>(p), isGet);
+        case FieldType<short>::value:
+            return accessField(L, static_cast<short*>(p), isGet);
+        case FieldType<unsigned short>::value:
+            return accessField(L, static_cast<unsigned short*>(p), isGet);
+        case FieldType<int>::value:
+            return accessField(L, static_cast<int*>(p), isGet);
+        case FieldType<unsigned int>::value:
+            return accessField(L, static_cast<unsigned int*>(p), isGet);
+        case FieldType<long>::value:
+            return accessField(L, static_cast<long*>(p), isGet);
+        case FieldType<unsigned long>::value:
+            return accessField(L, static_cast<unsigned long*>(p), isGet);
+        case FieldType<long long>::value:
+            return accessField(L, static_cast<long long*>(p), isGet);
+        case FieldType<unsigned long long>::value:
+            return accessField(L, static_cast<unsigned long long*>(p), isGet);
+        case FieldType<float>::value:
+            return accessField(L, static_cast<float*>(p), isGet);
+        case FieldType<double>::value:
+            return accessField(L, static_cast<double*>(p), isGet);
+        default:
+            assert(false);
+            return 0;
         }
-        catch (const std::exception& e)
+    }
+
+    template<class T>
+    static int accessField(lua_State* L, T* field, bool isGet)
+    {
+        if (isGet)
         {
-            luaL_error(L, e.what());
+            Stack<T>::push(L, *field);
+            return 1;
         }
+
+        *field = ArgGetter<T, checkedCalls>::get(L, 2);
         return 0;
     }
 };
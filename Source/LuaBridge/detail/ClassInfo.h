@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
 namespace luabridge {
 
 namespace detail {
@@ -100,6 +104,147 @@ inline const void* getParentKey()
 #endif
 }
 
+/**
+ * The key of the registration options in a class table.
+ */
+inline const void* getOptionsKey()
+{
+#ifdef _NDEBUG
+    static char value;
+    return &value;
+#else
+    return reinterpret_cast<void*>(0x0b7);
+#endif
+}
+
+/**
+ * The key of the derived class tables list in a class table.
+ */
+inline const void* getChildrenKey()
+{
+#ifdef _NDEBUG
+    static char value;
+    return &value;
+#else
+    return reinterpret_cast<void*>(0xc1d);
+#endif
+}
+
+/**
+ * The key of the table recording the members copied from the parent classes.
+ */
+inline const void* getInheritedKey()
+{
+#ifdef _NDEBUG
+    static char value;
+    return &value;
+#else
+    return reinterpret_cast<void*>(0x1e7);
+#endif
+}
+
+/**
+ * The key of the class identity in a class or const table.
+ */
+inline const void* getClassInfoKey()
+{
+#ifdef _NDEBUG
+    static char value;
+    return &value;
+#else
+    return reinterpret_cast<void*>(0x1d7);
+#endif
+}
+
+/**
+ * The key of the identity cache of the pointers in a class or const table.
+ */
+inline const void* getIdentityCacheKey()
+{
+#ifdef _NDEBUG
+    static char value;
+    return &value;
+#else
+    return reinterpret_cast<void*>(0x1dc);
+#endif
+}
+
+/**
+ * The key of the list of all the identity caches in the registry.
+ */
+inline const void* getIdentityCachesKey()
+{
+    static char value;
+    return &value;
+}
+
+/**
+    Allocate a new class identifier.
+*/
+inline int nextClassId()
+{
+    static std::atomic<int> lastId(0);
+    return ++lastId;
+}
+
+/**
+    Get the identifier of a class.
+    The identifiers are small integers unique within the process.
+*/
+template<class T>
+int getClassId()
+{
+    static int const id = nextClassId();
+    return id;
+}
+
+/**
+    The identity of a registered class, shared by its objects.
+
+    Each class and const table owns one, allocated in a userdata which is
+    followed by the sorted identifiers of the class and all its parents.
+    The object userdata headers point to it, so checking whether an object
+    is derived from a class takes a binary search over a few integers.
+*/
+struct ClassInfo
+{
+    ClassInfo(int classId,
+              bool isConst,
+              int baseCount,
+              std::size_t valueAlignment,
+              bool hasIdentityCache)
+        : classId(classId)
+        , isConst(isConst)
+        , baseCount(baseCount)
+        , valueAlignment(valueAlignment)
+        , hasIdentityCache(hasIdentityCache)
+    {
+    }
+
+    /**
+        The size of a class identity with the given number of base identifiers.
+    */
+    static std::size_t size(int baseCount) { return sizeof(ClassInfo) + baseCount * sizeof(int); }
+
+    int* bases() { return reinterpret_cast<int*>(this + 1); }
+
+    int const* bases() const { return reinterpret_cast<int const*>(this + 1); }
+
+    /**
+        Check whether the class is the same as or derived from another class.
+    */
+    bool isDerivedFrom(int baseId) const
+    {
+        return std::binary_search(bases(), bases() + baseCount, baseId);
+    }
+
+    int const classId;
+    bool const isConst;
+    int const baseCount;
+    std::size_t const valueAlignment; // the alignment of the objects stored in the userdata
+    bool const hasIdentityCache; // the table has an identity cache of the pointers
+};
+
 /**
     Get the key for the static table in the Lua registry.
     The static table holds the static data members, static properties, and
@@ -4,4 +4,24 @@
 
 #pragma once
 
-// Empty file
+namespace luabridge {
+
+namespace detail {
+
+/**
+  Whether the bound functions validate their arguments by default.
+
+  Define LUABRIDGE_UNCHECKED_CALLS to make every bound function trust the
+  types of the object and of the arguments, as if it was registered with
+  luabridge::unchecked. The data member accessors trust them too. The types
+  are still asserted in debug builds.
+*/
+#ifdef LUABRIDGE_UNCHECKED_CALLS
+bool const checkedCalls = false;
+#else
+bool const checkedCalls = true;
+#endif
+
+} // namespace detail
+
+} // namespace luabridge
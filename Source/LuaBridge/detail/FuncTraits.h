@@ -7,8 +7,12 @@
 
 #include <LuaBridge/detail/Config.h>
 #include <LuaBridge/detail/TypeList.h>
+#include <LuaBridge/detail/TypeTraits.h>
 
+#include <cstddef>
 #include <functional>
+#include <tuple>
+#include <type_traits>
 
 namespace luabridge {
 
@@ -273,9 +277,14 @@ ReturnType doCall(T* obj, MemFn& fn, TypeListValues<Params>& tvl)
 
     Expansions are provided for functions with up to 8 parameters. This can be
     manually extended, or expanded to an arbitrary amount using C++11 features.
+
+    The other types are function objects, described by their operator().
 */
+template<class Functor, class Call>
+struct FunctorTraits;
+
 template<class MemFn, class D = MemFn>
-struct FuncTraits
+struct FuncTraits : FunctorTraits<MemFn, decltype(&MemFn::operator())>
 {
 };
 
@@ -362,17 +371,118 @@ struct FuncTraits<std::function<R(ParamList...)>>
     }
 };
 
-template<class ReturnType, class Params, int startParam>
+/* Function objects, like lambdas. The operator() must not be overloaded. */
+
+template<class Functor, class C, class R, class... ParamList>
+struct FunctorTraits<Functor, R (C::*)(ParamList...)>
+{
+    static bool const isMemberFunction = false;
+    static bool const isConstMemberFunction = false;
+    using DeclType = Functor;
+    using ReturnType = R;
+    using Params = typename MakeTypeList<ParamList...>::Result;
+
+    static ReturnType call(DeclType& fn, TypeListValues<Params>& tvl)
+    {
+        return doCall<ReturnType>(fn, tvl);
+    }
+};
+
+template<class Functor, class C, class R, class... ParamList>
+struct FunctorTraits<Functor, R (C::*)(ParamList...) const>
+    : FunctorTraits<Functor, R (C::*)(ParamList...)>
+{
+};
+
+//==============================================================================
+/**
+    Pushes the value returned by a call onto the Lua stack.
+
+    The returned value is passed to Stack<R>::push() as an rvalue, so the
+    registered classes are moved into their userdata.
+
+    @tparam R           The returned type.
+    @tparam passesState Whether the function has a lua_State* parameter.
+*/
+template<class R, bool passesState = false, class Enable = void>
+struct ResultStack
+{
+    static int const count = 1;
+
+    template<class Call>
+    static void push(lua_State* L, Call const& call)
+    {
+        Stack<R>::push(L, call());
+    }
+};
+
+/**
+    A registered class returned by value is constructed directly in the
+    storage of a new userdata, the call result initializing it in place.
+
+    The userdata is pushed before the call, so the functions accessing the
+    Lua stack through a lua_State* parameter use the generic version and
+    see the stack unchanged.
+*/
+template<class R>
+struct ResultStack<R,
+                   false,
+                   typename std::enable_if<std::is_class<R>::value && !std::is_const<R>::value &&
+                                           IsUserdata<R>::value &&
+                                           !TypeTraits::isContainer<R>::value &&
+                                           !IsTuple<R>::value>::type>
+{
+    static int const count = 1;
+
+    template<class Call>
+    static void push(lua_State* L, Call const& call)
+    {
+        UserdataValue<R>* const ud = UserdataValue<R>::place(L);
+        new (ud->getObject()) R(call());
+        ud->commit(L);
+    }
+};
+
+/**
+    A std::tuple returned by a function is pushed as multiple values, one per
+    element, instead of a table.
+*/
+template<class... Ts, bool passesState>
+struct ResultStack<std::tuple<Ts...>, passesState>
+{
+    static int const count = sizeof...(Ts);
+
+    template<class Call>
+    static void push(lua_State* L, Call const& call)
+    {
+        pushElements(L, call(), MakeIndexSequence<sizeof...(Ts)>());
+    }
+
+private:
+    template<std::size_t... Is>
+    static void pushElements(lua_State* L, std::tuple<Ts...> const& values, IndexSequence<Is...>)
+    {
+        int const pushed[] = {
+            0, (Stack<Ts>::push(L, std::get<Is>(values)), 0)...};
+        (void) pushed;
+        (void) L;
+        (void) values;
+    }
+};
+
+template<class ReturnType, class Params, int startParam, bool isChecked = true>
 struct Invoke
 {
+    typedef ResultStack<ReturnType, HasStateParam<Params>::value> Result;
+
     template<class Fn>
     static int run(lua_State* L, Fn& fn)
     {
         try
         {
-            ArgList<Params, startParam> args(L);
-            Stack<ReturnType>::push(L, FuncTraits<Fn>::call(fn, args));
-            return 1;
+            ArgList<Params, startParam, isChecked> args(L);
+            Result::push(L, [&]() -> ReturnType { return FuncTraits<Fn>::call(fn, args); });
+            return Result::count;
         }
         catch (const std::exception& e)
         {
@@ -385,9 +495,10 @@ struct Invoke
     {
         try
         {
-            ArgList<Params, startParam> args(L);
-            Stack<ReturnType>::push(L, FuncTraits<MemFn>::call(object, fn, args));
-            return 1;
+            ArgList<Params, startParam, isChecked> args(L);
+            Result::push(
+                L, [&]() -> ReturnType { return FuncTraits<MemFn>::call(object, fn, args); });
+            return Result::count;
         }
         catch (const std::exception& e)
         {
@@ -396,15 +507,15 @@ struct Invoke
     }
 };
 
-template<class Params, int startParam>
-struct Invoke<void, Params, startParam>
+template<class Params, int startParam, bool isChecked>
+struct Invoke<void, Params, startParam, isChecked>
 {
     template<class Fn>
     static int run(lua_State* L, Fn& fn)
     {
         try
         {
-            ArgList<Params, startParam> args(L);
+            ArgList<Params, startParam, isChecked> args(L);
             FuncTraits<Fn>::call(fn, args);
             return 0;
         }
@@ -419,7 +530,7 @@ struct Invoke<void, Params, startParam>
     {
         try
         {
-            ArgList<Params, startParam> args(L);
+            ArgList<Params, startParam, isChecked> args(L);
             FuncTraits<MemFn>::call(object, fn, args);
             return 0;
         }
@@ -0,0 +1,211 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace luabridge {
+
+namespace detail {
+
+/**
+  A slot of a handle map.
+
+  The generation is bumped each time the object of the slot is erased, which
+  makes all the handles to the slot stale.
+*/
+struct HandleSlot
+{
+    void* object;
+    std::uint32_t generation;
+};
+
+/**
+  The slots of a handle map.
+
+  They are shared by the map and all its handles, including those held by
+  Lua, so a handle outliving its map is stale instead of dangling.
+*/
+struct HandleSlots
+{
+    /**
+      Get the object of a slot.
+
+      @returns A pointer to the object or a null pointer for a stale handle.
+    */
+    void* getObject(std::uint32_t index, std::uint32_t generation) const
+    {
+        HandleSlot const& slot = slots[index];
+        return slot.generation == generation ? slot.object : 0;
+    }
+
+    std::vector<HandleSlot> slots;
+    std::vector<std::uint32_t> free;
+};
+
+class UserdataHandle;
+
+} // namespace detail
+
+template<class T>
+class Handle;
+
+//------------------------------------------------------------------------------
+/**
+  A map of objects owned by C++ to generation-checked handles.
+
+  A handle pushed to Lua refers to a slot of the map instead of the object,
+  so Lua code keeping it after the object is erased gets a Lua error instead
+  of a dangling pointer. Checking a handle takes one comparison.
+
+  The handles share the ownership of the slots, they become stale when the
+  map is destroyed. A slot whose generation is exhausted is retired rather
+  than reused, so a stale handle never becomes valid again. The map is not
+  thread-safe.
+*/
+class HandleMap
+{
+public:
+    HandleMap() : m_slots(std::make_shared<detail::HandleSlots>()), m_size(0) {}
+
+    /**
+      Erase all the objects, making their handles stale.
+    */
+    ~HandleMap()
+    {
+        for (detail::HandleSlot& slot : m_slots->slots)
+        {
+            if (slot.object != 0)
+            {
+                slot.object = 0;
+                ++slot.generation;
+            }
+        }
+    }
+
+    /**
+      Add an object to the map.
+
+      @param object A pointer to an object owned by C++.
+      @returns A handle to the object.
+    */
+    template<class T>
+    Handle<T> insert(T* object)
+    {
+        assert(object != 0);
+
+        std::uint32_t index;
+        if (m_slots->free.empty())
+        {
+            detail::HandleSlot const newSlot = {0, 1};
+            index = static_cast<std::uint32_t>(m_slots->slots.size());
+            m_slots->slots.push_back(newSlot);
+        }
+        else
+        {
+            index = m_slots->free.back();
+            m_slots->free.pop_back();
+        }
+
+        detail::HandleSlot& slot = m_slots->slots[index];
+        slot.object = const_cast<void*>(static_cast<void const*>(object));
+        ++m_size;
+        return Handle<T>(m_slots, index, slot.generation);
+    }
+
+    /**
+      Remove an object from the map, typically before it is destroyed.
+
+      All the handles to the object become stale, including those held by
+      Lua. Erasing a stale handle or a handle of another map does nothing.
+    */
+    template<class T>
+    void erase(Handle<T> const& handle)
+    {
+        if (handle.m_slots != m_slots || !handle.isValid())
+        {
+            return;
+        }
+
+        detail::HandleSlot& slot = m_slots->slots[handle.m_index];
+        slot.object = 0;
+        if (++slot.generation != maxGeneration)
+        {
+            m_slots->free.push_back(handle.m_index);
+        }
+        --m_size;
+    }
+
+    /**
+      The number of objects in the map.
+    */
+    std::size_t size() const { return m_size; }
+
+private:
+    HandleMap(HandleMap const&);
+    HandleMap& operator=(HandleMap const&);
+
+    static std::uint32_t const maxGeneration = 0xffffffff;
+
+    std::shared_ptr<detail::HandleSlots> const m_slots;
+    std::size_t m_size;
+};
+
+//------------------------------------------------------------------------------
+/**
+  A generation-checked reference to an object of a HandleMap.
+
+  Pushing a handle to Lua creates a userdata of the registered class T whose
+  object is looked up through the handle on each access.
+*/
+template<class T>
+class Handle
+{
+public:
+    /**
+      Construct a null handle.
+    */
+    Handle() : m_index(0), m_generation(0) {}
+
+    /**
+      Check whether the object of the handle is still in its map.
+    */
+    bool isValid() const { return m_slots && m_slots->slots[m_index].generation == m_generation; }
+
+    /**
+      Get the object of the handle.
+
+      @returns A pointer to the object or a null pointer for a stale handle.
+    */
+    T* get() const
+    {
+        return m_slots ? static_cast<T*>(m_slots->getObject(m_index, m_generation)) : 0;
+    }
+
+    std::shared_ptr<detail::HandleSlots> const& getSlots() const { return m_slots; }
+
+    std::uint32_t getIndex() const { return m_index; }
+
+    std::uint32_t getGeneration() const { return m_generation; }
+
+private:
+    friend class HandleMap;
+    friend class detail::UserdataHandle;
+
+    Handle(std::shared_ptr<detail::HandleSlots> const& slots,
+           std::uint32_t index,
+           std::uint32_t generation)
+        : m_slots(slots), m_index(index), m_generation(generation)
+    {
+    }
+
+    std::shared_ptr<detail::HandleSlots> m_slots;
+    std::uint32_t m_index;
+    std::uint32_t m_generation;
+};
+
+} // namespace luabridge
@@ -122,6 +122,94 @@ private:
     Iterator operator++(int);
 };
 
+/** Allows table iteration without registry references.
+
+    The current key and value are kept on the top of the Lua stack, so the
+    stack must be restored to its state after each step before the iterator
+    is incremented. The stack is restored on destruction.
+
+    e.g. @code
+    for (StackIterator it(table); !it.isNil(); ++it)
+    {
+        sum += it.value().cast<int>();
+    }
+    @endcode
+ */
+class StackIterator
+{
+    lua_State* m_L;
+    int m_table;
+    int m_top;
+    bool m_isNil;
+
+    void next()
+    {
+        assert(lua_gettop(m_L) == m_top + 1); // Stack: key
+        m_isNil = lua_next(m_L, m_table) == 0; // Stack: key, value | -
+    }
+
+public:
+    explicit StackIterator(const LuaStackRef& table)
+        : m_L(table.state()), m_table(table.index()), m_top(lua_gettop(m_L)), m_isNil(true)
+    {
+        lua_pushnil(m_L); // Stack: nil
+        next();
+    }
+
+    ~StackIterator() { lua_settop(m_L, m_top); }
+
+    /// Return an associated Lua state.
+    ///
+    /// @returns A Lua state.
+    ///
+    lua_State* state() const { return m_L; }
+
+    /// Move the iterator to the next table entry.
+    ///
+    /// @returns This iterator.
+    ///
+    StackIterator& operator++()
+    {
+        if (!m_isNil)
+        {
+            lua_settop(m_L, m_top + 1); // Stack: key
+            next();
+        }
+        return *this;
+    }
+
+    /// Check if the iterator points after the last table entry.
+    ///
+    /// @returns True if there are no more table entries to iterate,
+    ///         false otherwise.
+    ///
+    bool isNil() const { return m_isNil; }
+
+    /// Return the key for the current table entry.
+    ///
+    /// @returns A view of the entry key.
+    ///
+    LuaStackRef key() const
+    {
+        assert(!m_isNil);
+        return LuaStackRef(m_L, m_top + 1);
+    }
+
+    /// Return the value for the current table entry.
+    ///
+    /// @returns A view of the entry value.
+    ///
+    LuaStackRef value() const
+    {
+        assert(!m_isNil);
+        return LuaStackRef(m_L, m_top + 2);
+    }
+
+private:
+    StackIterator(const StackIterator&);
+    StackIterator& operator=(const StackIterator&);
+};
+
 namespace detail {
 
 class Range
@@ -130,12 +218,168 @@ class Range
     Iterator m_end;
 
 public:
-    Range(const Iterator& begin, const Iterator& end) : m_begin(begin), m_end(end) {}
+    Range(Iterator begin, Iterator end) : m_begin(std::move(begin)), m_end(std::move(end)) {}
 
     const Iterator& begin() const { return m_begin; }
     const Iterator& end() const { return m_end; }
 };
 
+/** A range of a table pushed on the Lua stack.
+
+    The table is pushed when the range is constructed and the stack is
+    restored when the range is destroyed. The current entry is kept on the
+    stack above the table, so the range can be iterated only once.
+ */
+class StackRange
+{
+protected:
+    lua_State* m_L;
+    int m_top;
+
+    template<class Table>
+    explicit StackRange(const Table& table) : m_L(table.state()), m_top(lua_gettop(m_L))
+    {
+        table.push(m_L); // Stack: table
+    }
+
+    StackRange(StackRange&& other) : m_L(other.m_L), m_top(other.m_top) { other.m_L = 0; }
+
+    ~StackRange()
+    {
+        if (m_L != 0)
+        {
+            lua_settop(m_L, m_top);
+        }
+    }
+
+    int tableIndex() const { return m_top + 1; }
+
+private:
+    StackRange(const StackRange&);
+    StackRange& operator=(const StackRange&);
+};
+
+/** A range of the typed key-value pairs of a table, see luabridge::pairs<K, V>().
+ */
+template<class K, class V>
+class PairsRange : public StackRange
+{
+public:
+    class iterator
+    {
+        lua_State* m_L;
+        int m_table;
+        bool m_isEnd;
+
+        void next()
+        {
+            m_isEnd = lua_next(m_L, m_table) == 0; // Stack: table, key, value | table
+        }
+
+    public:
+        iterator(lua_State* L, int table, bool isEnd) : m_L(L), m_table(table), m_isEnd(isEnd)
+        {
+            if (!isEnd)
+            {
+                lua_pushnil(m_L); // Stack: table, nil
+                next();
+            }
+        }
+
+        /** The key is read from a copy, since getters like the char const*
+            one convert a number key in place, which lua_next can't resume
+            from. The copy stays on the stack until the next entry, keeping
+            the converted string alive.
+        */
+        std::pair<K, V> operator*() const
+        {
+            lua_settop(m_L, m_table + 2); // Stack: table, key, value
+            lua_pushvalue(m_L, m_table + 1); // Stack: table, key, value, key copy
+            return std::pair<K, V>(Stack<K>::get(m_L, m_table + 3),
+                                   Stack<V>::get(m_L, m_table + 2));
+        }
+
+        bool operator!=(const iterator& rhs) const { return m_isEnd != rhs.m_isEnd; }
+
+        iterator& operator++()
+        {
+            if (!m_isEnd)
+            {
+                lua_settop(m_L, m_table + 1); // Stack: table, key
+                next();
+            }
+            return *this;
+        }
+    };
+
+    template<class Table>
+    explicit PairsRange(const Table& table) : StackRange(table)
+    {
+    }
+
+    iterator begin() { return iterator(m_L, tableIndex(), false); }
+    iterator end() { return iterator(m_L, tableIndex(), true); }
+};
+
+/** A range of the typed values of a table array part, see luabridge::ipairs<V>().
+ */
+template<class V>
+class IpairsRange : public StackRange
+{
+public:
+    class iterator
+    {
+        lua_State* m_L;
+        int m_table;
+        int m_index;
+
+        void next()
+        {
+            lua_rawgeti(m_L, m_table, m_index); // Stack: table, value
+            if (lua_isnil(m_L, -1))
+            {
+                lua_pop(m_L, 1); // Stack: table
+                m_index = 0;
+            }
+        }
+
+    public:
+        iterator(lua_State* L, int table, int index) : m_L(L), m_table(table), m_index(index)
+        {
+            if (m_index != 0)
+            {
+                next();
+            }
+        }
+
+        std::pair<int, V> operator*() const
+        {
+            return std::pair<int, V>(m_index, Stack<V>::get(m_L, m_table + 1));
+        }
+
+        bool operator!=(const iterator& rhs) const { return m_index != rhs.m_index; }
+
+        iterator& operator++()
+        {
+            if (m_index != 0)
+            {
+                lua_settop(m_L, m_table); // Stack: table
+                ++m_index;
+                next();
+            }
+            return *this;
+        }
+    };
+
+    template<class Table>
+    explicit IpairsRange(const Table& table) : StackRange(table)
+    {
+    }
+
+    iterator begin() { return iterator(m_L, tableIndex(), 1); }
+    iterator end() { return iterator(m_L, tableIndex(), 0); }
+};
+
 } // namespace detail
 
 /// Return a range for the Lua table reference.
@@ -147,4 +391,36 @@ inline detail::Range pairs(const LuaRef& table)
     return detail::Range(Iterator(table, false), Iterator(table, true));
 }
 
+/// Return a range of the typed key-value pairs of a table.
+///
+/// The entries are traversed with lua_next on the Lua stack and converted
+/// by Stack<K>::get and Stack<V>::get, no registry reference is created.
+///
+/// e.g. @code
+/// for (std::pair<std::string, int> entry : pairs<std::string, int>(table))
+/// @endcode
+///
+/// @param table A LuaRef or LuaStackRef to a table.
+/// @returns A range suitable for range-based for statement.
+///
+template<class K, class V, class Table>
+detail::PairsRange<K, V> pairs(const Table& table)
+{
+    return detail::PairsRange<K, V>(table);
+}
+
+/// Return a range of the typed values of a table array part.
+///
+/// The values are read by lua_rawgeti from the index 1 up to the first nil
+/// and converted by Stack<V>::get, no registry reference is created.
+///
+/// @param table A LuaRef or LuaStackRef to a table.
+/// @returns A range of index-value pairs suitable for range-based for statement.
+///
+template<class V, class Table>
+detail::IpairsRange<V> ipairs(const Table& table)
+{
+    return detail::IpairsRange<V>(table);
+}
+
 } // namespace luabridge
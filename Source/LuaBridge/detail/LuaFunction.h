@@ -0,0 +1,242 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <LuaBridge/detail/CFunctions.h>
+#include <LuaBridge/detail/LuaRef.h>
+
+#include <functional>
+#include <memory>
+
+namespace luabridge {
+
+template<class Signature>
+class LuaFunction;
+
+//------------------------------------------------------------------------------
+/**
+    A typed reference to a Lua function.
+
+    The arguments are pushed by Stack<Args> and the results are converted
+    straight to R, without creating a LuaRef for them. R is void for no
+    result, a type for one result or a std::tuple for several results.
+
+    e.g. @code
+    LuaFunction<int(int, int)> const add = getGlobal(L, "add");
+    int const sum = add(1, 2);
+    @endcode
+*/
+template<class R, class... Args>
+class LuaFunction<R(Args...)>
+{
+public:
+    //----------------------------------------------------------------------------
+    /**
+        Reference a Lua function.
+
+        @param function A reference to a function or a callable object.
+    */
+    LuaFunction(LuaRef const& function)
+        : m_function(function), m_handler(function.state()), m_hasHandler(false)
+    {
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Reference a Lua function called with a message handler.
+
+        The message handler is called by the protected calls with the error
+        object and returns the object of the thrown LuaException, typically
+        with a traceback.
+
+        @param function       A reference to a function or a callable object.
+        @param messageHandler A reference to a message handler function.
+    */
+    LuaFunction(LuaRef const& function, LuaRef const& messageHandler)
+        : m_function(function), m_handler(messageHandler), m_hasHandler(!messageHandler.isNil())
+    {
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Return the lua_State associated with the function.
+    */
+    lua_State* state() const { return m_function.state(); }
+
+    //----------------------------------------------------------------------------
+    /**
+        Return a reference to the function.
+    */
+    LuaRef const& toLuaRef() const { return m_function; }
+
+    //----------------------------------------------------------------------------
+    /**
+        Call the function in protected mode.
+
+        @param args The arguments of the call.
+        @returns The results of the call.
+        @throws LuaException if an error occurs.
+    */
+    R operator()(Args const&... args) const
+    {
+        lua_State* const L = state();
+        StackRestore restore(L);
+
+        int handler = 0;
+        if (m_hasHandler)
+        {
+            m_handler.push();
+            handler = lua_gettop(L);
+        }
+
+        pushCall(args...);
+        int const code = lua_pcall(L, sizeof...(Args), detail::LuaResults<R>::count, handler);
+        if (code != LUABRIDGE_LUA_OK)
+        {
+            LuaException::Throw(LuaException(L, code));
+        }
+        return detail::LuaResults<R>::get(L, lua_gettop(L) - detail::LuaResults<R>::count + 1);
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Call the function in unprotected mode.
+
+        This is meant for trusted callbacks only, an error raised by the
+        function is not caught and propagates to the enclosing protected
+        call or to the panic function.
+
+        @param args The arguments of the call.
+        @returns The results of the call.
+    */
+    R call(Args const&... args) const
+    {
+        lua_State* const L = state();
+        StackRestore restore(L);
+
+        pushCall(args...);
+        lua_call(L, sizeof...(Args), detail::LuaResults<R>::count);
+        return detail::LuaResults<R>::get(L, lua_gettop(L) - detail::LuaResults<R>::count + 1);
+    }
+
+private:
+    /**
+        Restore the Lua stack on destruction, after the return value is built.
+    */
+    class StackRestore
+    {
+    public:
+        explicit StackRestore(lua_State* L) : m_L(L), m_top(lua_gettop(L)) {}
+
+        ~StackRestore() { lua_settop(m_L, m_top); }
+
+    private:
+        lua_State* m_L;
+        int m_top;
+    };
+
+    void pushCall(Args const&... args) const
+    {
+        lua_State* const L = state();
+        m_function.push();
+        int const pushed[] = {0, (Stack<Args>::push(L, args), 0)...};
+        (void) pushed;
+    }
+
+    LuaRef m_function;
+    LuaRef m_handler;
+    bool m_hasHandler;
+};
+
+//------------------------------------------------------------------------------
+/**
+    Stack specialization for `LuaFunction`.
+*/
+template<class Signature>
+struct Stack<LuaFunction<Signature>>
+{
+    static void push(lua_State* L, LuaFunction<Signature> const& f) { f.toLuaRef().push(L); }
+
+    static LuaFunction<Signature> get(lua_State* L, int index)
+    {
+        return LuaFunction<Signature>(LuaRef::fromStack(L, index));
+    }
+};
+
+namespace detail {
+
+//------------------------------------------------------------------------------
+/**
+    A callable wrapping a Lua function into a std::function.
+
+    The copies of the std::function share the same registry reference.
+*/
+template<class Signature>
+class LuaCallback;
+
+template<class R, class... Args>
+class LuaCallback<R(Args...)>
+{
+public:
+    explicit LuaCallback(LuaRef const& function)
+        : m_function(std::make_shared<LuaFunction<R(Args...)>>(function))
+    {
+    }
+
+    R operator()(Args... args) const { return (*m_function)(args...); }
+
+    LuaFunction<R(Args...)> const& getFunction() const { return *m_function; }
+
+private:
+    std::shared_ptr<LuaFunction<R(Args...)> const> m_function;
+};
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+/**
+    Stack specialization for `std::function`.
+
+    Getting a Lua function wraps it in a callable converting the results
+    straight to R, see LuaFunction. Pushing a C++ function creates a C
+    closure, and pushing back a wrapped Lua function pushes the original
+    function. An empty std::function is nil.
+*/
+template<class R, class... Args>
+struct Stack<std::function<R(Args...)>>
+{
+    typedef detail::LuaCallback<R(Args...)> Callback;
+
+    static void push(lua_State* L, std::function<R(Args...)> const& f)
+    {
+        if (!f)
+        {
+            lua_pushnil(L);
+        }
+        else if (Callback const* callback = f.template target<Callback>())
+        {
+            callback->getFunction().toLuaRef().push(L);
+        }
+        else
+        {
+            detail::CFunc::pushFunctor(L, f);
+        }
+    }
+
+    static std::function<R(Args...)> get(lua_State* L, int index)
+    {
+        if (lua_isnil(L, index))
+        {
+            return std::function<R(Args...)>();
+        }
+        return Callback(LuaRef::fromStack(L, index));
+    }
+
+    static bool isInstance(lua_State* L, int index)
+    {
+        return lua_isfunction(L, index) || lua_isnil(L, index);
+    }
+};
+
+} // namespace luabridge
@@ -66,6 +66,11 @@ inline int get_length(lua_State* L, int idx)
     return int(lua_objlen(L, idx));
 }
 
+inline int get_rawlength(lua_State* L, int idx)
+{
+    return int(lua_objlen(L, idx));
+}
+
 #else // LUA_VERSION_NUM < 502
 
 inline int get_length(lua_State* L, int idx)
@@ -76,6 +81,11 @@ inline int get_length(lua_State* L, int idx)
     return len;
 }
 
+inline int get_rawlength(lua_State* L, int idx)
+{
+    return int(lua_rawlen(L, idx));
+}
+
 #endif // LUA_VERSION_NUM >= 502
 
 #ifndef LUA_OK
@@ -105,6 +115,24 @@ inline void rawsetfield(lua_State* L, int index, char const* key)
     lua_rawset(L, index);
 }
 
+/** Set a value in two tables under the same key, bypassing metamethods.
+
+    The key string is pushed once for both tables.
+ */
+inline void rawsetfield(lua_State* L, int index1, int index2, char const* key)
+{
+    assert(lua_istable(L, index1));
+    assert(lua_istable(L, index2));
+    index1 = lua_absindex(L, index1);
+    index2 = lua_absindex(L, index2);
+    lua_pushstring(L, key); // Stack: value, key
+    lua_pushvalue(L, -1); // Stack: value, key, key
+    lua_pushvalue(L, -3); // Stack: value, key, key, value
+    lua_rawset(L, index1); // Stack: value, key
+    lua_insert(L, -2); // Stack: key, value
+    lua_rawset(L, index2); // Stack: -
+}
+
 /** Returns true if the value is a full userdata (not light).
  */
 inline bool isfulluserdata(lua_State* L, int index)
@@ -0,0 +1,266 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <LuaBridge/detail/LuaRef.h>
+
+#include <initializer_list>
+
+namespace luabridge {
+
+//------------------------------------------------------------------------------
+/**
+    A compiled path of string keys to a nested table value.
+
+    The keys are interned once, in a table held by a single registry
+    reference. Resolving the path walks the tables on the Lua stack and
+    creates no other registry reference, unlike a chain of LuaRef::operator[].
+
+    e.g. @code
+    LuaPath const speed(L, {"config", "player", "speed"});
+    double const value = speed.get<double>(); // config.player.speed
+    @endcode
+
+    The path is resolved from the global table, or from any root reference
+    having a push(lua_State*) member like LuaRef or LuaStackRef. Reading
+    through a nil value returns nil. Writing requires all the intermediate
+    tables to exist.
+*/
+class LuaPath
+{
+public:
+    //----------------------------------------------------------------------------
+    /**
+        Compile a path.
+
+        @param L    A Lua state.
+        @param keys The keys of the nested values, from the outermost.
+    */
+    LuaPath(lua_State* L, std::initializer_list<char const*> keys)
+        : m_L(L), m_size(static_cast<int>(keys.size()))
+    {
+        assert(m_size > 0);
+
+        lua_createtable(m_L, m_size, 0);
+        int i = 1;
+        for (char const* key : keys)
+        {
+            lua_pushstring(m_L, key);
+            lua_rawseti(m_L, -2, i++);
+        }
+        m_keysRef = luaL_ref(m_L, LUA_REGISTRYINDEX);
+    }
+
+    LuaPath(LuaPath&& other) noexcept
+        : m_L(other.m_L), m_size(other.m_size), m_keysRef(other.m_keysRef)
+    {
+        other.m_keysRef = LUA_NOREF;
+    }
+
+    ~LuaPath() { luaL_unref(m_L, LUA_REGISTRYINDEX, m_keysRef); }
+
+    //----------------------------------------------------------------------------
+    /**
+        Return the lua_State associated with the path.
+    */
+    lua_State* state() const { return m_L; }
+
+    //----------------------------------------------------------------------------
+    /**
+        Push the value at the path onto the Lua stack.
+        This invokes metamethods.
+
+        @param root The root table reference.
+    */
+    template<class Root>
+    void push(Root const& root) const
+    {
+        root.push(m_L);
+        resolve(m_size, false);
+    }
+
+    void push() const
+    {
+        pushGlobals();
+        resolve(m_size, false);
+    }
+
+    //----------------------------------------------------------------------------
+    /** @{ */
+    /**
+        Get the value at the path.
+        This invokes metamethods.
+
+        @param root The root table reference, the global table by default.
+        @returns The value converted by Stack<T>.
+    */
+    template<class T, class Root>
+    T get(Root const& root) const
+    {
+        root.push(m_L);
+        return getResolved<T>(false);
+    }
+
+    template<class T>
+    T get() const
+    {
+        pushGlobals();
+        return getResolved<T>(false);
+    }
+    /** @} */
+
+    //----------------------------------------------------------------------------
+    /** @{ */
+    /**
+        Get the value at the path.
+        The operation is raw, metamethods are not invoked and reading through
+        a value which is not a table returns nil.
+
+        @param root The root table reference, the global table by default.
+        @returns The value converted by Stack<T>.
+    */
+    template<class T, class Root>
+    T rawget(Root const& root) const
+    {
+        root.push(m_L);
+        return getResolved<T>(true);
+    }
+
+    template<class T>
+    T rawget() const
+    {
+        pushGlobals();
+        return getResolved<T>(true);
+    }
+    /** @} */
+
+    //----------------------------------------------------------------------------
+    /** @{ */
+    /**
+        Set the value at the path.
+        This invokes metamethods.
+
+        @param root  The root table reference, the global table by default.
+        @param value The value pushed by Stack<T>.
+    */
+    template<class T, class Root>
+    void set(Root const& root, T const& value) const
+    {
+        root.push(m_L);
+        setResolved(value, false);
+    }
+
+    template<class T>
+    void set(T const& value) const
+    {
+        pushGlobals();
+        setResolved(value, false);
+    }
+    /** @} */
+
+    //----------------------------------------------------------------------------
+    /** @{ */
+    /**
+        Set the value at the path.
+        The operation is raw, metamethods are not invoked.
+
+        @param root  The root table reference, the global table by default.
+        @param value The value pushed by Stack<T>.
+    */
+    template<class T, class Root>
+    void rawset(Root const& root, T const& value) const
+    {
+        root.push(m_L);
+        setResolved(value, true);
+    }
+
+    template<class T>
+    void rawset(T const& value) const
+    {
+        pushGlobals();
+        setResolved(value, true);
+    }
+    /** @} */
+
+private:
+    LuaPath(LuaPath const&);
+    LuaPath& operator=(LuaPath const&);
+
+    void pushGlobals() const
+    {
+#if LUA_VERSION_NUM < 502
+        lua_pushvalue(m_L, LUA_GLOBALSINDEX);
+#else
+        lua_rawgeti(m_L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+#endif
+    }
+
+    /**
+        Replace the root on the top of the stack with its value at the first
+        keys of the path.
+    */
+    void resolve(int count, bool raw) const
+    {
+        lua_rawgeti(m_L, LUA_REGISTRYINDEX, m_keysRef); // Stack: root, keys
+        lua_insert(m_L, -2); // Stack: keys, root
+        for (int i = 1; i <= count; ++i)
+        {
+            if (lua_isnil(m_L, -1) || (raw && !lua_istable(m_L, -1)))
+            {
+                lua_pop(m_L, 1);
+                lua_pushnil(m_L); // Stack: keys, nil
+                break;
+            }
+
+            lua_rawgeti(m_L, -2, i); // Stack: keys, table, key
+            if (raw)
+            {
+                lua_rawget(m_L, -2); // Stack: keys, table, value
+            }
+            else
+            {
+                lua_gettable(m_L, -2); // Stack: keys, table, value
+            }
+            lua_remove(m_L, -2); // Stack: keys, value
+        }
+        lua_remove(m_L, -2); // Stack: value
+    }
+
+    template<class T>
+    T getResolved(bool raw) const
+    {
+        resolve(m_size, raw); // Stack: value
+        detail::StackPop p(m_L, 1);
+        return Stack<T>::get(m_L, -1);
+    }
+
+    template<class T>
+    void setResolved(T const& value, bool raw) const
+    {
+        resolve(m_size - 1, raw); // Stack: table
+        detail::StackPop p(m_L, 1);
+        if (raw && !lua_istable(m_L, -1))
+        {
+            luaL_error(m_L, "attempt to index a %s value", luaL_typename(m_L, -1));
+        }
+        lua_rawgeti(m_L, LUA_REGISTRYINDEX, m_keysRef); // Stack: table, keys
+        lua_rawgeti(m_L, -1, m_size); // Stack: table, keys, key
+        lua_remove(m_L, -2); // Stack: table, key
+        Stack<T>::push(m_L, value); // Stack: table, key, value
+        if (raw)
+        {
+            lua_rawset(m_L, -3); // Stack: table
+        }
+        else
+        {
+            lua_settable(m_L, -3); // Stack: table
+        }
+    }
+
+    lua_State* m_L;
+    int m_size;
+    int m_keysRef;
+};
+
+} // namespace luabridge
@@ -8,10 +8,12 @@
 
 #include <LuaBridge/detail/LuaException.h>
 #include <LuaBridge/detail/Stack.h>
+#include <LuaBridge/detail/TypeTraits.h>
 
 #include <iostream>
 #include <map>
 #include <string>
+#include <tuple>
 
 namespace luabridge {
 
@@ -42,47 +44,96 @@ struct Stack<Nil>
     static bool isInstance(lua_State* L, int index) { return lua_type(L, index) == LUA_TNIL; }
 };
 
+namespace detail {
+
+//------------------------------------------------------------------------------
 /**
- * Base class for Lua variables and table item reference classes.
- */
-template<class Impl, class LuaRef>
-class LuaRefBase
-{
-protected:
-    //----------------------------------------------------------------------------
-    /**
-        Pop the Lua stack.
+    Pop the Lua stack.
 
-        Pops the specified number of stack items on destruction. We use this
-        when returning objects, to avoid an explicit temporary variable, since
-        the destructor executes after the return statement. For example:
+    Pops the specified number of stack items on destruction. We use this
+    when returning objects, to avoid an explicit temporary variable, since
+    the destructor executes after the return statement. For example:
 
-            template <class U>
-            U cast (lua_State* L)
-            {
-              StackPop p (L, 1);
-              ...
-              return U (); // dtor called after this line
-            }
+        template <class U>
+        U cast (lua_State* L)
+        {
+          StackPop p (L, 1);
+          ...
+          return U (); // dtor called after this line
+        }
 
-        @note The `StackPop` object must always be a named local variable.
+    @note The `StackPop` object must always be a named local variable.
+*/
+class StackPop
+{
+public:
+    /** Create a StackPop object.
+
+        @param L     A Lua state.
+        @param count The number of stack entries to pop on destruction.
     */
-    class StackPop
+    StackPop(lua_State* L, int count) : m_L(L), m_count(count) {}
+
+    ~StackPop() { lua_pop(m_L, m_count); }
+
+private:
+    lua_State* m_L;
+    int m_count;
+};
+
+//------------------------------------------------------------------------------
+/**
+    Convert the results of a Lua call to a C++ type.
+
+    A single result is converted by Stack<R>, a std::tuple takes one result
+    per element and void takes none.
+*/
+template<class R>
+struct LuaResults
+{
+    static int const count = 1;
+
+    static R get(lua_State* L, int index) { return Stack<R>::get(L, index); }
+};
+
+template<>
+struct LuaResults<void>
+{
+    static int const count = 0;
+
+    static void get(lua_State*, int) {}
+};
+
+template<class... Rs>
+struct LuaResults<std::tuple<Rs...>>
+{
+    static int const count = sizeof...(Rs);
+
+    static std::tuple<Rs...> get(lua_State* L, int index)
     {
-    public:
-        /** Create a StackPop object.
+        return get(L, index, MakeIndexSequence<sizeof...(Rs)>());
+    }
 
-            @param L     A Lua state.
-            @param count The number of stack entries to pop on destruction.
-        */
-        StackPop(lua_State* L, int count) : m_L(L), m_count(count) {}
+private:
+    template<std::size_t... Is>
+    static std::tuple<Rs...> get(lua_State* L, int index, IndexSequence<Is...>)
+    {
+        (void) L;
+        (void) index;
+        return std::tuple<Rs...>(Stack<Rs>::get(L, index + static_cast<int>(Is))...);
+    }
+};
 
-        ~StackPop() { lua_pop(m_L, m_count); }
+} // namespace detail
 
-    private:
-        lua_State* m_L;
-        int m_count;
-    };
+/**
+ * Base class for Lua variables and table item reference classes.
+ */
+template<class Impl, class LuaRef>
+class LuaRefBase
+{
+protected:
+    typedef detail::StackPop StackPop;
 
     friend struct Stack<LuaRef>;
 
@@ -521,6 +572,29 @@ public:
         return LuaRef::fromStack(m_L);
     }
 
+    //----------------------------------------------------------------------------
+    /**
+        Call Lua code and convert its results.
+        The results are converted by Stack<R>, a std::tuple takes one result
+        per element and void takes none. If an error occurs, a LuaException
+        is thrown.
+
+        e.g. @code
+        std::tuple<int, int> const r = f.callAs<std::tuple<int, int>>(17, 5);
+        @endcode
+
+        @returns The results of the call.
+    */
+    template<class R, typename... Arguments>
+    R callAs(Arguments&&... arguments) const
+    {
+        impl().push();
+        pushArguments(std::forward<Arguments>(arguments)...);
+        LuaException::pcall(m_L, sizeof...(arguments), detail::LuaResults<R>::count);
+        StackPop p(m_L, detail::LuaResults<R>::count);
+        return detail::LuaResults<R>::get(m_L, lua_gettop(m_L) - detail::LuaResults<R>::count + 1);
+    }
+
     //============================================================================
 
 protected:
@@ -594,6 +668,20 @@ class LuaRef : public LuaRefBase<LuaRef, LuaRef>
             m_keyRef = luaL_ref(m_L, LUA_REGISTRYINDEX);
         }
 
+        //--------------------------------------------------------------------------
+        /**
+            Create a TableItem taking over the references of another one.
+
+            @param other Another Lua table item reference, left without
+                         references.
+        */
+        TableItem(TableItem&& other) noexcept
+            : LuaRefBase(other.m_L), m_tableRef(other.m_tableRef), m_keyRef(other.m_keyRef)
+        {
+            other.m_tableRef = LUA_NOREF;
+            other.m_keyRef = LUA_NOREF;
+        }
+
         //--------------------------------------------------------------------------
         /**
             Destroy the proxy.
@@ -625,6 +713,16 @@ class LuaRef : public LuaRefBase<LuaRef, LuaRef>
             return *this;
         }
 
+        //--------------------------------------------------------------------------
+        /**
+            Assign the value of another table item to this table key.
+            This may invoke metamethods.
+
+            @param v A table item reference.
+            @returns This reference.
+        */
+        TableItem& operator=(TableItem const& v) { return operator=<TableItem>(v); }
+
         //--------------------------------------------------------------------------
         /**
             Assign a new value to this table key.
@@ -765,6 +863,17 @@ public:
     */
     LuaRef(LuaRef const& other) : LuaRefBase(other.m_L), m_ref(other.createRef()) {}
 
+    //----------------------------------------------------------------------------
+    /**
+        Take over the reference of another LuaRef.
+
+        @param other An existing reference, left without reference.
+    */
+    LuaRef(LuaRef&& other) noexcept : LuaRefBase(other.m_L), m_ref(other.m_ref)
+    {
+        other.m_ref = LUA_NOREF;
+    }
+
     //----------------------------------------------------------------------------
     /**
         Destroy a reference.
@@ -846,6 +955,25 @@ public:
         return *this;
     }
 
+    //----------------------------------------------------------------------------
+    /**
+        Take over the reference of another LuaRef.
+
+        @param rhs A reference to move from, left without reference.
+        @returns This reference.
+    */
+    LuaRef& operator=(LuaRef&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            luaL_unref(m_L, LUA_REGISTRYINDEX, m_ref);
+            m_L = rhs.m_L;
+            m_ref = rhs.m_ref;
+            rhs.m_ref = LUA_NOREF;
+        }
+        return *this;
+    }
+
     //----------------------------------------------------------------------------
     /**
         Assign a table item reference.
@@ -976,6 +1104,151 @@ struct Stack<LuaRef::TableItem>
     static void push(lua_State* L, LuaRef::TableItem const& v) { v.push(L); }
 };
 
+//------------------------------------------------------------------------------
+/**
+    Lightweight view of a value on the Lua stack.
+
+    The view refers to a stack slot and never touches the registry, which
+    makes it cheaper than a LuaRef for inspecting the arguments of a C++
+    function. It is only valid while the slot holds the value, use
+    toLuaRef() to keep the value longer.
+*/
+class LuaStackRef : public LuaRefBase<LuaStackRef, LuaRef>
+{
+public:
+    //----------------------------------------------------------------------------
+    /**
+        A proxy for reading a table value by key, without registry references.
+
+        The table is the viewed stack value or, for the chained accesses, the
+        value of the parent proxy, looked up again on each read.
+    */
+    template<class K, class Parent = LuaStackRef>
+    class Item : public LuaRefBase<Item<K, Parent>, LuaRef>
+    {
+    public:
+        Item(Parent const& parent, K const& key)
+            : LuaRefBase<Item<K, Parent>, LuaRef>(parent.state()), m_parent(parent), m_key(key)
+        {
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+            Push the value onto the Lua stack.
+            This invokes metamethods.
+        */
+        using LuaRefBase<Item<K, Parent>, LuaRef>::push;
+
+        void push() const
+        {
+            m_parent.push();
+            Stack<K>::push(this->m_L, m_key);
+            lua_gettable(this->m_L, -2);
+            lua_remove(this->m_L, -2); // remove the table
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+            Access a value of this table value using a key.
+            This invokes metamethods.
+
+            @param key A key in the table.
+            @returns A proxy to the table item.
+        */
+        template<class T>
+        Item<T, Item<K, Parent>> operator[](T key) const
+        {
+            return Item<T, Item<K, Parent>>(*this, key);
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+            Create a registry reference to the value.
+
+            @returns A Lua value reference.
+        */
+        LuaRef toLuaRef() const
+        {
+            push();
+            return LuaRef::fromStack(this->m_L);
+        }
+
+    private:
+        Parent m_parent;
+        K m_key;
+    };
+
+    //----------------------------------------------------------------------------
+    /**
+        Create a view of a Lua stack item.
+
+        @param L     A Lua state.
+        @param index The index of the value on the Lua stack.
+    */
+    LuaStackRef(lua_State* L, int index) : LuaRefBase(L), m_index(lua_absindex(L, index)) {}
+
+    //----------------------------------------------------------------------------
+    /**
+        Return the absolute index of the viewed value on the Lua stack.
+    */
+    int index() const { return m_index; }
+
+    //----------------------------------------------------------------------------
+    /**
+        Place the object onto the Lua stack.
+    */
+    using LuaRefBase::push;
+
+    void push() const { lua_pushvalue(m_L, m_index); }
+
+    //----------------------------------------------------------------------------
+    /**
+        Access a table value using a key.
+        This invokes metamethods.
+
+        @param key A key in the table.
+        @returns A proxy to the table item.
+    */
+    template<class T>
+    Item<T> operator[](T key) const
+    {
+        return Item<T>(*this, key);
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Create a registry reference to the value.
+
+        @returns A Lua value reference.
+    */
+    LuaRef toLuaRef() const { return LuaRef::fromStack(m_L, m_index); }
+
+private:
+    int m_index;
+};
+
+//------------------------------------------------------------------------------
+/**
+ * Stack specialization for `LuaStackRef`.
+ */
+template<>
+struct Stack<LuaStackRef>
+{
+    static void push(lua_State* L, LuaStackRef const& v) { v.push(L); }
+
+    static LuaStackRef get(lua_State* L, int index) { return LuaStackRef(L, index); }
+};
+
+//------------------------------------------------------------------------------
+/**
+ * Stack specialization for `LuaStackRef::Item`.
+ */
+template<class K, class Parent>
+struct Stack<LuaStackRef::Item<K, Parent>>
+{
+    static void push(lua_State* L, LuaStackRef::Item<K, Parent> const& v) { v.push(L); }
+};
+
 //------------------------------------------------------------------------------
 /**
     Create a reference to a new, empty table.
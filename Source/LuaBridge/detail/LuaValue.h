@@ -0,0 +1,303 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <LuaBridge/detail/LuaRef.h>
+
+#include <utility>
+
+namespace luabridge {
+
+//------------------------------------------------------------------------------
+/**
+    A Lua value held by C++, storing the primitive values inline.
+
+    Nil, booleans, numbers and light userdata are kept in the object itself,
+    so creating, pushing and destroying them never touches the registry.
+    Strings, tables, functions, full userdata and threads are held by a
+    registry reference like LuaRef. Integers keep their subtype on Lua 5.3
+    and later.
+
+    e.g. @code
+    LuaValue const speed(L, 1.5); // no registry reference
+    LuaValue const config = getGlobal(L, "config"); // a registry reference
+    @endcode
+*/
+class LuaValue : public LuaRefBase<LuaValue, LuaRef>
+{
+public:
+    //----------------------------------------------------------------------------
+    /**
+        Create a nil value.
+
+        @param L A Lua state.
+    */
+    LuaValue(lua_State* L) : LuaRefBase(L), m_type(LUA_TNIL), m_isInteger(false), m_value() {}
+
+    //----------------------------------------------------------------------------
+    /**
+        Convert a value with Stack<T> and hold the result.
+
+        @param L A Lua state.
+        @param v A value to push.
+    */
+    template<class T>
+    LuaValue(lua_State* L, T v)
+        : LuaRefBase(L), m_type(LUA_TNIL), m_isInteger(false), m_value()
+    {
+        Stack<T>::push(m_L, v);
+        pop();
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Hold the value of a reference.
+
+        @param v A LuaRef, a table item or a Lua stack view.
+    */
+    template<class Impl>
+    LuaValue(LuaRefBase<Impl, LuaRef> const& v)
+        : LuaRefBase(v.state()), m_type(LUA_TNIL), m_isInteger(false), m_value()
+    {
+        v.push(m_L);
+        pop();
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Copy a value, creating a new registry reference if needed.
+
+        @param other An existing value.
+    */
+    LuaValue(LuaValue const& other)
+        : LuaRefBase(other.m_L), m_type(other.m_type), m_isInteger(other.m_isInteger)
+    {
+        if (other.isInline())
+        {
+            m_value = other.m_value;
+        }
+        else
+        {
+            m_value.ref = other.createRef();
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Take over the value of another LuaValue.
+
+        @param other An existing value, left nil.
+    */
+    LuaValue(LuaValue&& other) noexcept
+        : LuaRefBase(other.m_L), m_type(other.m_type), m_isInteger(other.m_isInteger)
+    {
+        m_value = other.m_value;
+        other.m_type = LUA_TNIL;
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Destroy the value, releasing its registry reference if any.
+    */
+    ~LuaValue() { release(); }
+
+    //----------------------------------------------------------------------------
+    /**
+        Hold a copy of the value on a Lua stack.
+        The stack item is not removed.
+
+        @param L     A Lua state.
+        @param index An index in the Lua stack.
+        @returns The value.
+    */
+    static LuaValue fromStack(lua_State* L, int index = -1)
+    {
+        lua_pushvalue(L, index);
+        LuaValue value(L);
+        value.pop();
+        return value;
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Assign another value.
+
+        @param rhs An existing value.
+        @returns This value.
+    */
+    LuaValue& operator=(LuaValue const& rhs)
+    {
+        LuaValue value(rhs);
+        swap(value);
+        return *this;
+    }
+
+    LuaValue& operator=(LuaValue&& rhs) noexcept
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Return the Lua type of the value, without pushing it.
+
+        @returns The type of the value.
+    */
+    int type() const { return m_type; }
+
+    //----------------------------------------------------------------------------
+    /**
+        Check whether the value is stored inline, without a registry reference.
+    */
+    bool isInline() const
+    {
+        return m_type == LUA_TNIL || m_type == LUA_TBOOLEAN || m_type == LUA_TNUMBER ||
+               m_type == LUA_TLIGHTUSERDATA;
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Place the value onto the Lua stack.
+    */
+    using LuaRefBase::push;
+
+    void push() const
+    {
+        switch (m_type)
+        {
+        case LUA_TNIL:
+            lua_pushnil(m_L);
+            break;
+
+        case LUA_TBOOLEAN:
+            lua_pushboolean(m_L, m_value.boolean ? 1 : 0);
+            break;
+
+        case LUA_TNUMBER:
+            if (m_isInteger)
+            {
+                lua_pushinteger(m_L, m_value.integer);
+            }
+            else
+            {
+                lua_pushnumber(m_L, m_value.number);
+            }
+            break;
+
+        case LUA_TLIGHTUSERDATA:
+            lua_pushlightuserdata(m_L, m_value.pointer);
+            break;
+
+        default:
+            lua_rawgeti(m_L, LUA_REGISTRYINDEX, m_value.ref);
+            break;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Pop the top of Lua stack and hold it.
+    */
+    void pop()
+    {
+        release();
+
+        m_type = lua_type(m_L, -1);
+        m_isInteger = false;
+        switch (m_type)
+        {
+        case LUA_TNONE:
+            m_type = LUA_TNIL;
+            return;
+
+        case LUA_TNIL:
+            break;
+
+        case LUA_TBOOLEAN:
+            m_value.boolean = lua_toboolean(m_L, -1) != 0;
+            break;
+
+        case LUA_TNUMBER:
+#if LUA_VERSION_NUM >= 503
+            if (lua_isinteger(m_L, -1))
+            {
+                m_isInteger = true;
+                m_value.integer = lua_tointeger(m_L, -1);
+                break;
+            }
+#endif
+            m_value.number = lua_tonumber(m_L, -1);
+            break;
+
+        case LUA_TLIGHTUSERDATA:
+            m_value.pointer = lua_touserdata(m_L, -1);
+            break;
+
+        default:
+            m_value.ref = luaL_ref(m_L, LUA_REGISTRYINDEX);
+            return;
+        }
+        lua_pop(m_L, 1);
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Create a registry reference to the value.
+
+        @returns A Lua value reference.
+    */
+    LuaRef toLuaRef() const
+    {
+        push();
+        return LuaRef::fromStack(m_L);
+    }
+
+private:
+    void release()
+    {
+        if (!isInline())
+        {
+            luaL_unref(m_L, LUA_REGISTRYINDEX, m_value.ref);
+            m_type = LUA_TNIL;
+        }
+    }
+
+    void swap(LuaValue& other)
+    {
+        std::swap(m_L, other.m_L);
+        std::swap(m_type, other.m_type);
+        std::swap(m_isInteger, other.m_isInteger);
+        std::swap(m_value, other.m_value);
+    }
+
+    union Value
+    {
+        bool boolean;
+        lua_Integer integer;
+        lua_Number number;
+        void* pointer;
+        int ref;
+    };
+
+    int m_type;
+    bool m_isInteger;
+    Value m_value;
+};
+
+//------------------------------------------------------------------------------
+/**
+ * Stack specialization for `LuaValue`.
+ */
+template<>
+struct Stack<LuaValue>
+{
+    // The value is const& to prevent a copy construction.
+    //
+    static void push(lua_State* L, LuaValue const& v) { v.push(L); }
+
+    static LuaValue get(lua_State* L, int index) { return LuaValue::fromStack(L, index); }
+};
+
+} // namespace luabridge
@@ -9,11 +9,16 @@
 #include <LuaBridge/detail/ClassInfo.h>
 #include <LuaBridge/detail/Config.h>
 #include <LuaBridge/detail/LuaException.h>
+#include <LuaBridge/detail/Options.h>
 #include <LuaBridge/detail/Security.h>
 #include <LuaBridge/detail/TypeTraits.h>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace luabridge {
 
@@ -166,13 +171,17 @@ class Namespace : public detail::Registrar
 
           The Lua stack should have the const table on top.
         */
-        void createClassTable(char const* name)
+        void createClassTable(char const* name, Options options)
         {
             // Stack: namespace table (ns), const table (co)
 
             // Class table is the same as const table except the propset table
             createConstTable(name, false); // Stack: ns, co, cl
 
+            lua_pushinteger(L,
+                            static_cast<lua_Integer>(options.value())); // Stack: ns, co, cl, options
+            lua_rawsetp(L, -2, detail::getOptionsKey()); // Stack: ns, co, cl
+
             lua_newtable(L); // Stack: ns, co, cl, propset table (ps)
             lua_rawsetp(L, -2, detail::getPropsetKey()); // cl [propsetKey] = ps. Stack: ns, co, cl
 
@@ -181,6 +190,44 @@ class Namespace : public detail::Registrar
 
             lua_pushvalue(L, -1); // Stack: ns, co, cl, cl
             lua_rawsetp(L, -3, detail::getClassKey()); // co [classKey] = cl. Stack: ns, co, cl
+
+            if (options.test(identityCache))
+            {
+                createIdentityCache(); // Stack: ns, co, cl, cache
+                lua_rawsetp(L, -2, detail::getIdentityCacheKey()); // Stack: ns, co, cl
+                createIdentityCache(); // Stack: ns, co, cl, cache
+                lua_rawsetp(L, -3, detail::getIdentityCacheKey()); // Stack: ns, co, cl
+            }
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Create a table with weak values for the userdata of the pointers.
+
+          The cache is also added to the list of all the caches of the Lua
+          state, which invalidate() goes through.
+        */
+        void createIdentityCache()
+        {
+            lua_newtable(L); // Stack: cache
+            lua_newtable(L); // Stack: cache, metatable (mt)
+            lua_pushliteral(L, "v"); // Stack: cache, mt, "v"
+            lua_setfield(L, -2, "__mode"); // Stack: cache, mt
+            lua_setmetatable(L, -2); // Stack: cache
+
+            lua_rawgetp(
+                L, LUA_REGISTRYINDEX, detail::getIdentityCachesKey()); // Stack: cache, list | nil
+            if (lua_isnil(L, -1))
+            {
+                lua_pop(L, 1); // Stack: cache
+                lua_newtable(L); // Stack: cache, list
+                lua_pushvalue(L, -1); // Stack: cache, list, list
+                lua_rawsetp(
+                    L, LUA_REGISTRYINDEX, detail::getIdentityCachesKey()); // Stack: cache, list
+            }
+            lua_pushvalue(L, -2); // Stack: cache, list, cache
+            lua_rawseti(L, -2, get_rawlength(L, -2) + 1); // Stack: cache, list
+            lua_pop(L, 1); // Stack: cache
         }
 
         //--------------------------------------------------------------------------
@@ -250,10 +297,371 @@ class Namespace : public detail::Registrar
             detail::ArgList<Params, 2> args(L);
             detail::UserdataValue<T>* value = detail::UserdataValue<T>::place(L);
             detail::Constructor<T, Params>::call(value->getObject(), args);
-            value->commit();
+            value->commit(L);
             return 1;
         }
 
+        //--------------------------------------------------------------------------
+        /**
+          Create the identity of a class or const table.
+
+          The parent table and the identity cache, if any, must be already set.
+
+          @param index          The class or const table index.
+          @param classId        The class identifier.
+          @param isConst        True for the const table.
+          @param valueAlignment The alignment of the class objects.
+        */
+        void createClassInfo(int index, int classId, bool isConst, std::size_t valueAlignment) const
+        {
+            index = lua_absindex(L, index);
+
+            detail::ClassInfo const* parent = 0;
+            lua_rawgetp(L, index, detail::getParentKey()); // Stack: parent table (pt) | nil
+            if (lua_istable(L, -1))
+            {
+                lua_rawgetp(L, -1, detail::getClassInfoKey()); // Stack: pt, parent info
+                parent = static_cast<detail::ClassInfo const*>(lua_touserdata(L, -1));
+                assert(parent != 0);
+                lua_pop(L, 1); // Stack: pt
+            }
+            lua_pop(L, 1); // Stack: -
+
+            lua_rawgetp(L, index, detail::getIdentityCacheKey()); // Stack: cache | nil
+            bool const hasIdentityCache = !lua_isnil(L, -1);
+            lua_pop(L, 1); // Stack: -
+
+            int const baseCount = parent ? parent->baseCount + 1 : 1;
+            detail::ClassInfo* const info =
+                new (lua_newuserdata(L, detail::ClassInfo::size(baseCount)))
+                    detail::ClassInfo(classId,
+                                      isConst,
+                                      baseCount,
+                                      valueAlignment,
+                                      hasIdentityCache); // Stack: info
+            if (parent)
+            {
+                std::copy(parent->bases(), parent->bases() + parent->baseCount, info->bases());
+            }
+            info->bases()[baseCount - 1] = classId;
+            std::sort(info->bases(), info->bases() + baseCount);
+            lua_rawsetp(L, index, detail::getClassInfoKey()); // Stack: -
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Get the registration options of a class.
+
+          @param clIndex The class table index.
+        */
+        Options getOptions(int clIndex) const
+        {
+            lua_rawgetp(L, clIndex, detail::getOptionsKey()); // Stack: options | nil
+            Options const options(static_cast<Options::ValueType>(lua_tointeger(L, -1)));
+            lua_pop(L, 1); // Stack: -
+            return options;
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Refresh the class tables which depend on the registered members.
+
+          The copies of the inherited members are dropped from the class and
+          all its derived classes, and their __index is reset to indexMetaMethod.
+          Then, if the registration is complete, the copies and the plain
+          method tables are made again for the classes registered with the
+          flattenInheritance and plainIndexTable options.
+
+          @param clIndex  The class table index.
+          @param complete False while the class is being registered.
+        */
+        void updateClassTables(int clIndex, bool complete) const
+        {
+            clIndex = lua_absindex(L, clIndex);
+            Options const options = getOptions(clIndex);
+            bool const flatten = complete && options.test(flattenInheritance);
+            bool const plain = complete && options.test(plainIndexTable);
+
+            lua_rawgetp(L, clIndex, detail::getConstKey()); // Stack: const table (co)
+            updateInheritedTable(lua_gettop(L), flatten);
+            updateIndexTable(lua_gettop(L), plain);
+            lua_pop(L, 1); // Stack: -
+            updateInheritedTable(clIndex, flatten);
+            updateIndexTable(clIndex, plain);
+
+            lua_rawgetp(L, clIndex, detail::getChildrenKey()); // Stack: children list | nil
+            if (lua_istable(L, -1))
+            {
+                int const count = get_length(L, -1);
+                for (int i = 1; i <= count; ++i)
+                {
+                    lua_rawgeti(L, -1, i); // Stack: children, child class table
+                    updateClassTables(-1, complete);
+                    lua_pop(L, 1); // Stack: children
+                }
+            }
+            lua_pop(L, 1); // Stack: -
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Set the __index of a class or const table.
+
+          A plain table of the member functions lets the Lua VM resolve
+          the method calls without entering indexMetaMethod. It is used only
+          if neither the class nor its parents have properties, since the
+          getters need the object which Lua does not pass to a nested __index.
+          A user-defined __index metamethod is never replaced.
+
+          @param index The absolute index of the table.
+          @param plain True to use a plain method table when possible.
+        */
+        void updateIndexTable(int index, bool plain) const
+        {
+            rawgetfield(L, index, "__index"); // Stack: __index
+            bool const isOwn =
+                lua_istable(L, -1) || lua_tocfunction(L, -1) == &CFunc::indexMetaMethod;
+            lua_pop(L, 1); // Stack: -
+
+            if (!isOwn)
+            {
+                return;
+            }
+
+            if (plain && !hasProperties(index))
+            {
+                createMethodTable(index); // Stack: method table
+            }
+            else
+            {
+                lua_pushcfunction(L, &CFunc::indexMetaMethod); // Stack: function
+            }
+            rawsetfield(L, index, "__index"); // Stack: -
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Check if a class or const table or any of its parents has properties.
+
+          @param index The absolute index of the table.
+        */
+        bool hasProperties(int index) const
+        {
+            bool found = false;
+
+            lua_pushvalue(L, index); // Stack: table (t)
+            while (!found && lua_istable(L, -1))
+            {
+                lua_rawgetp(L, -1, detail::getPropgetKey()); // Stack: t, propget table (pg)
+                lua_pushnil(L); // Stack: t, pg, nil
+                while (lua_next(L, -2) != 0) // Stack: t, pg, key, getter
+                {
+                    lua_pop(L, 1); // Stack: t, pg, key
+                    if (lua_type(L, -1) == LUA_TSTRING)
+                    {
+                        found = true;
+                        lua_pop(L, 1); // Stack: t, pg
+                        break;
+                    }
+                }
+                lua_pop(L, 1); // Stack: t
+
+                lua_rawgetp(L, -1, detail::getParentKey()); // Stack: t, parent table | nil
+                lua_remove(L, -2); // Stack: parent table | nil
+            }
+            lua_pop(L, 1); // Stack: -
+
+            return found;
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Create a table with the member functions of a class or const table
+          and of all its parents, the nearer class functions hide the farther ones.
+
+          @param index The absolute index of the table.
+        */
+        void createMethodTable(int index) const
+        {
+            lua_newtable(L); // Stack: method table (mt)
+            int const methods = lua_gettop(L);
+
+            lua_pushvalue(L, index); // Stack: mt, table (t)
+            while (lua_istable(L, -1))
+            {
+                lua_pushnil(L); // Stack: mt, t, nil
+                while (lua_next(L, -2) != 0) // Stack: mt, t, key, value
+                {
+                    if (lua_type(L, -2) == LUA_TSTRING && lua_iscfunction(L, -1) &&
+                        !isInternalMetaMethod(lua_tostring(L, -2)) && !isRawFieldSet(methods))
+                    {
+                        lua_pushvalue(L, -2); // Stack: mt, t, key, value, key
+                        lua_pushvalue(L, -2); // Stack: mt, t, key, value, key, value
+                        lua_rawset(L, methods); // Stack: mt, t, key, value
+                    }
+                    lua_pop(L, 1); // Stack: mt, t, key
+                }
+
+                lua_rawgetp(L, -1, detail::getParentKey()); // Stack: mt, t, parent table | nil
+                lua_remove(L, -2); // Stack: mt, parent table | nil
+            }
+            lua_pop(L, 1); // Stack: mt
+        }
+
+        static bool isInternalMetaMethod(char const* name)
+        {
+            return std::strcmp(name, "__gc") == 0 || std::strcmp(name, "__index") == 0 ||
+                   std::strcmp(name, "__newindex") == 0;
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Refresh the inherited members of a class or const table.
+
+          The lookup order of indexMetaMethod is preserved: the functions and
+          the getters of a nearer class hide the ones of a farther class.
+          Metamethods are not copied since Lua does not inherit them.
+        */
+        void updateInheritedTable(int index, bool flatten) const
+        {
+            lua_rawgetp(L, index, detail::getPropgetKey()); // Stack: propget table (pg)
+            lua_rawgetp(L, index, detail::getPropsetKey()); // Stack: pg, propset table (ps) | nil
+            int const pg = lua_gettop(L) - 1;
+            int const ps = lua_istable(L, -1) ? lua_gettop(L) : 0;
+
+            dropInherited(index);
+            dropInherited(pg);
+            if (ps != 0)
+            {
+                dropInherited(ps);
+            }
+
+            if (flatten)
+            {
+                lua_rawgetp(L, index, detail::getParentKey()); // Stack: pg, ps, parent table | nil
+                while (lua_istable(L, -1))
+                {
+                    int const parent = lua_gettop(L);
+                    copyInherited(index, parent, pg, true);
+
+                    lua_rawgetp(L, parent, detail::getPropgetKey()); // Stack: ..., parent pg
+                    copyInherited(pg, parent + 1, index, false);
+                    lua_pop(L, 1); // Stack: ..., parent
+
+                    lua_rawgetp(L, parent, detail::getPropsetKey()); // Stack: ..., parent ps | nil
+                    if (ps != 0 && lua_istable(L, -1))
+                    {
+                        copyInherited(ps, parent + 1, 0, false);
+                    }
+                    lua_pop(L, 1); // Stack: ..., parent
+
+                    lua_rawgetp(L, parent, detail::getParentKey()); // Stack: ..., parent, next
+                    lua_remove(L, parent); // Stack: ..., next parent table | nil
+                }
+                lua_pop(L, 1); // Stack: pg, ps
+            }
+
+            lua_pop(L, 2); // Stack: -
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Copy the named entries of a parent table missing in the target table.
+
+          Each copy is recorded so it can be dropped later without touching
+          the entries registered for the target class itself.
+
+          @param target    The absolute index of the table to fill.
+          @param source    The absolute index of the parent table.
+          @param shadow    The absolute index of a table whose entries also
+                           hide the parent ones, or 0.
+          @param functions True to copy only the functions which are not
+                           metamethods.
+        */
+        void copyInherited(int target, int source, int shadow, bool functions) const
+        {
+            lua_rawgetp(L, target, detail::getInheritedKey()); // Stack: record | nil
+            if (lua_isnil(L, -1))
+            {
+                lua_pop(L, 1); // Stack: -
+                lua_newtable(L); // Stack: record
+                lua_pushvalue(L, -1); // Stack: record, record
+                lua_rawsetp(L, target, detail::getInheritedKey()); // Stack: record
+            }
+            int const record = lua_gettop(L);
+
+            lua_pushnil(L); // Stack: record, nil
+            while (lua_next(L, source) != 0) // Stack: record, key, value
+            {
+                if (lua_type(L, -2) == LUA_TSTRING &&
+                    (!functions ||
+                     (lua_isfunction(L, -1) && std::strncmp(lua_tostring(L, -2), "__", 2) != 0)))
+                {
+                    bool hidden = isRawFieldSet(target);
+                    if (!hidden && shadow != 0)
+                    {
+                        hidden = isRawFieldSet(shadow);
+                    }
+
+                    if (!hidden)
+                    {
+                        lua_pushvalue(L, -2); // Stack: record, key, value, key
+                        lua_pushvalue(L, -2); // Stack: record, key, value, key, value
+                        lua_rawset(L, target); // Stack: record, key, value
+                        lua_pushvalue(L, -2); // Stack: record, key, value, key
+                        lua_pushvalue(L, -2); // Stack: record, key, value, key, value
+                        lua_rawset(L, record); // Stack: record, key, value
+                    }
+                }
+                lua_pop(L, 1); // Stack: record, key
+            }
+            lua_pop(L, 1); // Stack: -
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Remove the entries recorded by copyInherited() which are still in place.
+
+          @param index The absolute index of the table.
+        */
+        void dropInherited(int index) const
+        {
+            lua_rawgetp(L, index, detail::getInheritedKey()); // Stack: record | nil
+            if (lua_istable(L, -1))
+            {
+                lua_pushnil(L); // Stack: record, nil
+                while (lua_next(L, -2) != 0) // Stack: record, key, copy
+                {
+                    lua_pushvalue(L, -2); // Stack: record, key, copy, key
+                    lua_rawget(L, index); // Stack: record, key, copy, current value
+                    if (lua_rawequal(L, -1, -2))
+                    {
+                        lua_pushvalue(L, -3); // Stack: record, key, copy, current, key
+                        lua_pushnil(L); // Stack: record, key, copy, current, key, nil
+                        lua_rawset(L, index); // Stack: record, key, copy, current
+                    }
+                    lua_pop(L, 2); // Stack: record, key
+                }
+
+                lua_pushnil(L); // Stack: record, nil
+                lua_rawsetp(L, index, detail::getInheritedKey()); // Stack: record
+            }
+            lua_pop(L, 1); // Stack: -
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Check if a table has a value for the key found below the top of the stack.
+        */
+        bool isRawFieldSet(int index) const
+        {
+            lua_pushvalue(L, -2); // Stack: key, value, key
+            lua_rawget(L, index); // Stack: key, value, field | nil
+            bool const isSet = !lua_isnil(L, -1);
+            lua_pop(L, 1); // Stack: key, value
+            return isSet;
+        }
+
         void assertStackState() const
         {
             // Stack: const table (co), class table (cl), static table (st)
@@ -287,10 +695,12 @@ class Namespace : public detail::Registrar
         /**
           Register a new class or add to an existing class registration.
 
-          @param name   The new class name.
-          @param parent A parent namespace object.
+          @param name    The new class name.
+          @param parent  A parent namespace object.
+          @param options The registration options of a new class.
         */
-        Class(char const* name, Namespace& parent) : ClassBase(parent)
+        Class(char const* name, Namespace& parent, Options options = defaultOptions)
+            : ClassBase(parent)
         {
             assert(lua_istable(L, -1)); // Stack: namespace table (ns)
             rawgetfield(L, -1, name); // Stack: ns, static table (st) | nil
@@ -304,7 +714,7 @@ class Namespace : public detail::Registrar
                 rawsetfield(L, -2, "__gc"); // co ["__gc"] = function. Stack: ns, co
                 ++m_stackSize;
 
-                createClassTable(name); // Stack: ns, co, class table (cl)
+                createClassTable(name, options); // Stack: ns, co, class table (cl)
                 lua_pushcfunction(L, &CFunc::gcMetaMethod<T>); // Stack: ns, co, cl, function
                 rawsetfield(L, -2, "__gc"); // cl ["__gc"] = function. Stack: ns, co, cl
                 ++m_stackSize;
@@ -325,6 +735,9 @@ class Namespace : public detail::Registrar
                 lua_rawsetp(L,
                             LUA_REGISTRYINDEX,
                             detail::getConstRegistryKey<T>()); // Stack: ns, co, cl, st
+
+                createClassInfo(-3, detail::getClassId<T>(), true, alignof(T));
+                createClassInfo(-2, detail::getClassId<T>(), false, alignof(T));
             }
             else
             {
@@ -343,6 +756,9 @@ class Namespace : public detail::Registrar
                             detail::getClassRegistryKey<T>()); // Stack: ns, co, st, cl
                 lua_insert(L, -2); // Stack: ns, co, cl, st
                 ++m_stackSize;
+
+                // The members may change, drop what depends on them until endClass ()
+                updateClassTables(-2, false);
             }
         }
 
@@ -350,11 +766,16 @@ class Namespace : public detail::Registrar
         /**
           Derive a new class.
 
-          @param name     The class name.
-          @param parent A parent namespace object.
-          @param staticKey
+          @param name      The class name.
+          @param parent    A parent namespace object.
+          @param staticKey The registry key of the base class static table.
+          @param options   The registration options.
         */
-        Class(char const* name, Namespace& parent, void const* const staticKey) : ClassBase(parent)
+        Class(char const* name,
+              Namespace& parent,
+              void const* const staticKey,
+              Options options = defaultOptions)
+            : ClassBase(parent)
         {
             assert(lua_istable(L, -1)); // Stack: namespace table (ns)
 
@@ -363,7 +784,7 @@ class Namespace : public detail::Registrar
             rawsetfield(L, -2, "__gc"); // co ["__gc"] = function. Stack: ns, co
             ++m_stackSize;
 
-            createClassTable(name); // Stack: ns, co, class table (cl)
+            createClassTable(name, options); // Stack: ns, co, class table (cl)
             lua_pushcfunction(L, &CFunc::gcMetaMethod<T>); // Stack: ns, co, cl, function
             rawsetfield(L, -2, "__gc"); // cl ["__gc"] = function. Stack: ns, co, cl
             ++m_stackSize;
@@ -398,6 +819,20 @@ class Namespace : public detail::Registrar
             lua_rawsetp(
                 L, -2, detail::getParentKey()); // st [parentKey] = pst. Stack: ns, co, cl, st
 
+            lua_rawgetp(L, -2, detail::getParentKey()); // Stack: ns, co, cl, st, pcl
+            lua_rawgetp(
+                L, -1, detail::getChildrenKey()); // Stack: ns, co, cl, st, pcl, children | nil
+            if (lua_isnil(L, -1))
+            {
+                lua_pop(L, 1); // Stack: ns, co, cl, st, pcl
+                lua_newtable(L); // Stack: ns, co, cl, st, pcl, children
+                lua_pushvalue(L, -1); // Stack: ns, co, cl, st, pcl, children, children
+                lua_rawsetp(L, -3, detail::getChildrenKey()); // Stack: ns, co, cl, st, pcl, children
+            }
+            lua_pushvalue(L, -4); // Stack: ns, co, cl, st, pcl, children, cl
+            lua_rawseti(L, -2, get_length(L, -2) + 1); // Stack: ns, co, cl, st, pcl, children
+            lua_pop(L, 2); // Stack: ns, co, cl, st
+
             lua_pushvalue(L, -1); // Stack: ns, co, cl, st, st
             lua_rawsetp(
                 L, LUA_REGISTRYINDEX, detail::getStaticRegistryKey<T>()); // Stack: ns, co, cl, st
@@ -407,6 +842,9 @@ class Namespace : public detail::Registrar
             lua_pushvalue(L, -3); // Stack: ns, co, cl, st, co
             lua_rawsetp(
                 L, LUA_REGISTRYINDEX, detail::getConstRegistryKey<T>()); // Stack: ns, co, cl, st
+
+            createClassInfo(-3, detail::getClassId<T>(), true, alignof(T));
+            createClassInfo(-2, detail::getClassId<T>(), false, alignof(T));
         }
 
         //--------------------------------------------------------------------------
@@ -418,6 +856,7 @@ class Namespace : public detail::Registrar
         Namespace endClass()
         {
             assert(m_stackSize > 3);
+            updateClassTables(-2, true);
             m_stackSize -= 3;
             lua_pop(L, 3);
             return Namespace(*this);
@@ -512,20 +951,63 @@ class Namespace : public detail::Registrar
         //--------------------------------------------------------------------------
         /**
           Add or replace a static member function.
+
+          @param name   The name of the function.
+          @param fp     The function pointer.
+          @param checks Pass luabridge::unchecked to trust the argument types.
+          @returns This class registration object.
         */
-        template<class FP>
-        Class<T>& addStaticFunction(char const* name, FP const fp)
+        template<class FP, bool isChecked = detail::checkedCalls>
+        typename std::enable_if<std::is_pointer<FP>::value, Class<T>&>::type
+        addStaticFunction(char const* name,
+                          FP const fp,
+                          CallChecks<isChecked> /*checks*/ = CallChecks<isChecked>())
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
             lua_pushlightuserdata(L,
                                   reinterpret_cast<void*>(fp)); // Stack: co, cl, st, function ptr
-            lua_pushcclosure(L, &CFunc::Call<FP>::f, 1); // co, cl, st, function
+            lua_pushcclosure(L, &CFunc::Call<FP, isChecked>::f, 1); // co, cl, st, function
             rawsetfield(L, -2, name); // co, cl, st
 
             return *this;
         }
 
+        //--------------------------------------------------------------------------
+        /**
+          Add or replace a static member function known at compile time.
+
+          The resulting lua_CFunction calls the function directly, without
+          an upvalue.
+
+          @tparam FnPtr  The function pointer type.
+          @tparam fp     The function pointer.
+          @param  name   The name of the function.
+          @param  checks Pass luabridge::unchecked to trust the argument types.
+          @returns This class registration object.
+        */
+        template<class FnPtr, FnPtr fp, bool isChecked = detail::checkedCalls>
+        Class<T>& addStaticFunction(char const* name,
+                                    CallChecks<isChecked> /*checks*/ = CallChecks<isChecked>())
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            using Thunk = CFunc::CallBound<FnPtr, fp, isChecked>;
+            lua_pushcfunction(L, &Thunk::f); // co, cl, st, function
+            rawsetfield(L, -2, name); // co, cl, st
+
+            return *this;
+        }
+
+#ifdef LUABRIDGE_CXX17
+        template<auto fp, bool isChecked = detail::checkedCalls>
+        Class<T>& addStaticFunction(char const* name,
+                                    CallChecks<isChecked> checks = CallChecks<isChecked>())
+        {
+            return addStaticFunction<decltype(fp), fp>(name, checks);
+        }
+#endif // LUABRIDGE_CXX17
+
         //--------------------------------------------------------------------------
         /**
           Add or replace a static member function by std::function.
@@ -535,16 +1017,29 @@ class Namespace : public detail::Registrar
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
-            using FnType = decltype(function);
-            new (lua_newuserdata(L, sizeof(function)))
-                FnType(std::move(function)); // Stack: co, cl, st, function userdata (ud)
-            lua_newtable(L); // Stack: co, cl, st, ud, ud metatable (mt)
-            lua_pushcfunction(
-                L, &CFunc::gcMetaMethodAny<FnType>); // Stack: co, cl, st, ud, mt, gc function
-            rawsetfield(L, -2, "__gc"); // Stack: co, cl, st, ud, mt
-            lua_setmetatable(L, -2); // Stack: co, cl, st, ud
-            lua_pushcclosure(
-                L, &CFunc::CallProxyFunctor<FnType>::f, 1); // Stack: co, cl, st, function
+            CFunc::pushFunctor(L, std::move(function)); // Stack: co, cl, st, function
+            rawsetfield(L, -2, name); // Stack: co, cl, st
+
+            return *this;
+        }
+
+        //--------------------------------------------------------------------------
+        /**
+          Add or replace a static member function by a function object.
+
+          The function object, like a lambda, is stored in the Lua closure.
+          Its operator() must not be overloaded. The lambdas convertible to
+          lua_CFunction are added as lua_CFunction.
+        */
+        template<class Functor>
+        typename std::enable_if<std::is_class<Functor>::value &&
+                                    !std::is_convertible<Functor, lua_CFunction>::value,
+                                Class<T>&>::type
+        addStaticFunction(char const* name, Functor functor)
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            CFunc::pushFunctor(L, std::move(functor)); // Stack: co, cl, st, function
             rawsetfield(L, -2, name); // Stack: co, cl, st
 
             return *this;
@@ -590,26 +1085,58 @@ class Namespace : public detail::Registrar
         */
         template<class U>
         Class<T>& addData(char const* name, U T::* mp, bool isWritable = true)
+        {
+            return addData(name,
+                           mp,
+                           isWritable,
+                           std::integral_constant<bool, detail::IsOffsetField<T, U>::value>());
+        }
+
+    private:
+        //--------------------------------------------------------------------------
+        /**
+          Add or replace a data member of a standard-layout class.
+          A single accessor reading the member through its offset is used
+          as both the getter and the setter.
+        */
+        template<class U>
+        Class<T>& addData(char const* name, U T::* mp, bool isWritable, std::true_type)
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
-            typedef const U T::* mp_t;
-            new (lua_newuserdata(L, sizeof(mp_t))) mp_t(mp); // Stack: co, cl, st, field ptr
-            lua_pushcclosure(L, &CFunc::getProperty<T, U>, 1); // Stack: co, cl, st, getter
-            lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
-            CFunc::addGetter(L, name, -5); // Stack: co, cl, st, getter
-            CFunc::addGetter(L, name, -3); // Stack: co, cl, st
+            CFunc::pushFieldAccessor(L, mp); // Stack: co, cl, st, accessor
 
             if (isWritable)
             {
-                new (lua_newuserdata(L, sizeof(mp_t))) mp_t(mp); // Stack: co, cl, st, field ptr
-                lua_pushcclosure(L, &CFunc::setProperty<T, U>, 1); // Stack: co, cl, st, setter
+                lua_pushvalue(L, -1); // Stack: co, cl, st, accessor, accessor
+                CFunc::addSetter(L, name, -4); // Stack: co, cl, st, accessor
+            }
+
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
+
+            return *this;
+        }
+
+        template<class U>
+        Class<T>& addData(char const* name, U T::* mp, bool isWritable, std::false_type)
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            CFunc::pushPropertyAccessor<CFunc::GetProperty<T, U>>(
+                L, mp); // Stack: co, cl, st, getter
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
+
+            if (isWritable)
+            {
+                CFunc::pushPropertyAccessor<CFunc::SetProperty<T, U>>(
+                    L, mp); // Stack: co, cl, st, setter
                 CFunc::addSetter(L, name, -3); // Stack: co, cl, st
             }
 
             return *this;
         }
 
+    public:
         //--------------------------------------------------------------------------
         /**
           Add or replace a property member.
@@ -620,18 +1147,15 @@ class Namespace : public detail::Registrar
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
             typedef TG (T::*get_t)() const;
-            new (lua_newuserdata(L, sizeof(get_t))) get_t(get); // Stack: co, cl, st, function ptr
-            lua_pushcclosure(L, &CFunc::CallConstMember<get_t>::f, 1); // Stack: co, cl, st, getter
-            lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
-            CFunc::addGetter(L, name, -5); // Stack: co, cl, st, getter
-            CFunc::addGetter(L, name, -3); // Stack: co, cl, st
+            CFunc::pushPropertyAccessor<CFunc::CallConstMember<get_t>>(
+                L, get); // Stack: co, cl, st, getter
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
 
             if (set != 0)
             {
                 typedef void (T::*set_t)(TS);
-                new (lua_newuserdata(L, sizeof(set_t)))
-                    set_t(set); // Stack: co, cl, st, function ptr
-                lua_pushcclosure(L, &CFunc::CallMember<set_t>::f, 1); // Stack: co, cl, st, setter
+                CFunc::pushPropertyAccessor<CFunc::CallMember<set_t>>(
+                    L, set); // Stack: co, cl, st, setter
                 CFunc::addSetter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -650,18 +1174,15 @@ class Namespace : public detail::Registrar
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
             typedef TG (T::*get_t)(lua_State*) const;
-            new (lua_newuserdata(L, sizeof(get_t))) get_t(get); // Stack: co, cl, st, function ptr
-            lua_pushcclosure(L, &CFunc::CallConstMember<get_t>::f, 1); // Stack: co, cl, st, getter
-            lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
-            CFunc::addGetter(L, name, -5); // Stack: co, cl, st, getter
-            CFunc::addGetter(L, name, -3); // Stack: co, cl, st
+            CFunc::pushPropertyAccessor<CFunc::CallConstMember<get_t>>(
+                L, get); // Stack: co, cl, st, getter
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
 
             if (set != 0)
             {
                 typedef void (T::*set_t)(TS, lua_State*);
-                new (lua_newuserdata(L, sizeof(set_t)))
-                    set_t(set); // Stack: co, cl, st, function ptr
-                lua_pushcclosure(L, &CFunc::CallMember<set_t>::f, 1); // Stack: co, cl, st, setter
+                CFunc::pushPropertyAccessor<CFunc::CallMember<set_t>>(
+                    L, set); // Stack: co, cl, st, setter
                 CFunc::addSetter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -684,19 +1205,14 @@ class Namespace : public detail::Registrar
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
-            lua_pushlightuserdata(L,
-                                  reinterpret_cast<void*>(get)); // Stack: co, cl, st, function ptr
-            lua_pushcclosure(L, &CFunc::Call<TG (*)(const T*)>::f, 1); // Stack: co, cl, st, getter
-            lua_pushvalue(L, -1); // Stack: co, cl, st,, getter, getter
-            CFunc::addGetter(L, name, -5); // Stack: co, cl, st, getter
-            CFunc::addGetter(L, name, -3); // Stack: co, cl, st
+            CFunc::pushPropertyAccessor<CFunc::Call<TG (*)(const T*)>>(
+                L, get); // Stack: co, cl, st, getter
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
 
             if (set != 0)
             {
-                lua_pushlightuserdata(
-                    L, reinterpret_cast<void*>(set)); // Stack: co, cl, st, function ptr
-                lua_pushcclosure(
-                    L, &CFunc::Call<void (*)(T*, TS)>::f, 1); // Stack: co, cl, st, setter
+                CFunc::pushPropertyAccessor<CFunc::Call<void (*)(T*, TS)>>(
+                    L, set); // Stack: co, cl, st, setter
                 CFunc::addSetter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -718,10 +1234,8 @@ class Namespace : public detail::Registrar
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
-            lua_pushcfunction(L, get);
-            lua_pushvalue(L, -1); // Stack: co, cl, st,, getter, getter
-            CFunc::addGetter(L, name, -5); // Stack: co, cl, st,, getter
-            CFunc::addGetter(L, name, -3); // Stack: co, cl, st,
+            lua_pushcfunction(L, get); // Stack: co, cl, st, getter
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
 
             if (set != 0)
             {
@@ -747,9 +1261,7 @@ class Namespace : public detail::Registrar
             lua_setmetatable(L, -2); // Stack: co, cl, st, ud
             lua_pushcclosure(
                 L, &CFunc::CallProxyFunctor<GetType>::f, 1); // Stack: co, cl, st, getter
-            lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
-            CFunc::addGetter(L, name, -4); // Stack: co, cl, st, getter
-            CFunc::addGetter(L, name, -4); // Stack: co, cl, st
+            CFunc::addGetter(L, name, -4, -3); // Stack: co, cl, st
 
             if (set != nullptr)
             {
@@ -813,9 +1325,7 @@ class Namespace : public detail::Registrar
             lua_setmetatable(L, -2); // Stack: co, cl, st, ud
             lua_pushcclosure(
                 L, &CFunc::CallProxyFunctor<FnType>::f, 1); // Stack: co, cl, st, function
-            lua_pushvalue(L, -1); // Stack: co, cl, st, function, function
-            rawsetfield(L, -4, name); // Stack: co, cl, st, function
-            rawsetfield(L, -4, name); // Stack: co, cl, st
+            rawsetfield(L, -4, -3, name); // Stack: co, cl, st
 
             return *this;
         }
@@ -823,9 +1333,14 @@ class Namespace : public detail::Registrar
         //--------------------------------------------------------------------------
         /**
             Add or replace a member function.
+
+            Pass luabridge::unchecked as the last argument to trust the
+            object and argument types.
         */
-        template<class ReturnType, class... Params>
-        Class<T>& addFunction(char const* name, ReturnType (T::*mf)(Params...))
+        template<class ReturnType, class... Params, bool isChecked = detail::checkedCalls>
+        Class<T>& addFunction(char const* name,
+                              ReturnType (T::*mf)(Params...),
+                              CallChecks<isChecked> = CallChecks<isChecked>())
         {
             using MemFn = ReturnType (T::*)(Params...);
 
@@ -836,12 +1351,14 @@ class Namespace : public detail::Registrar
             {
                 throw std::logic_error(GC + " metamethod registration is forbidden");
             }
-            CFunc::CallMemberFunctionHelper<MemFn, false>::add(L, name, mf);
+            CFunc::CallMemberFunctionHelper<MemFn, false, isChecked>::add(L, name, mf);
             return *this;
         }
 
-        template<class ReturnType, class... Params>
-        Class<T>& addFunction(char const* name, ReturnType (T::*mf)(Params...) const)
+        template<class ReturnType, class... Params, bool isChecked = detail::checkedCalls>
+        Class<T>& addFunction(char const* name,
+                              ReturnType (T::*mf)(Params...) const,
+                              CallChecks<isChecked> = CallChecks<isChecked>())
         {
             using MemFn = ReturnType (T::*)(Params...) const;
 
@@ -852,7 +1369,7 @@ class Namespace : public detail::Registrar
             {
                 throw std::logic_error(GC + " metamethod registration is forbidden");
             }
-            CFunc::CallMemberFunctionHelper<MemFn, true>::add(L, name, mf);
+            CFunc::CallMemberFunctionHelper<MemFn, true, isChecked>::add(L, name, mf);
             return *this;
         }
 
@@ -860,8 +1377,10 @@ class Namespace : public detail::Registrar
         /**
             Add or replace a proxy function.
         */
-        template<class ReturnType, class... Params>
-        Class<T>& addFunction(char const* name, ReturnType (*proxyFn)(T* object, Params...))
+        template<class ReturnType, class... Params, bool isChecked = detail::checkedCalls>
+        Class<T>& addFunction(char const* name,
+                              ReturnType (*proxyFn)(T* object, Params...),
+                              CallChecks<isChecked> = CallChecks<isChecked>())
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
@@ -873,14 +1392,17 @@ class Namespace : public detail::Registrar
             using FnType = decltype(proxyFn);
             lua_pushlightuserdata(
                 L, reinterpret_cast<void*>(proxyFn)); // Stack: co, cl, st, function ptr
-            lua_pushcclosure(
-                L, &CFunc::CallProxyFunction<FnType>::f, 1); // Stack: co, cl, st, function
+            lua_pushcclosure(L,
+                             &CFunc::CallProxyFunction<FnType, isChecked>::f,
+                             1); // Stack: co, cl, st, function
             rawsetfield(L, -3, name); // Stack: co, cl, st
             return *this;
         }
 
-        template<class ReturnType, class... Params>
-        Class<T>& addFunction(char const* name, ReturnType (*proxyFn)(const T* object, Params...))
+        template<class ReturnType, class... Params, bool isChecked = detail::checkedCalls>
+        Class<T>& addFunction(char const* name,
+                              ReturnType (*proxyFn)(const T* object, Params...),
+                              CallChecks<isChecked> = CallChecks<isChecked>())
         {
             assertStackState(); // Stack: const table (co), class table (cl), static table (st)
 
@@ -892,14 +1414,54 @@ class Namespace : public detail::Registrar
             using FnType = decltype(proxyFn);
             lua_pushlightuserdata(
                 L, reinterpret_cast<void*>(proxyFn)); // Stack: co, cl, st, function ptr
-            lua_pushcclosure(
-                L, &CFunc::CallProxyFunction<FnType>::f, 1); // Stack: co, cl, st, function
-            lua_pushvalue(L, -1); // Stack: co, cl, st, function, function
-            rawsetfield(L, -4, name); // Stack: co, cl, st, function
-            rawsetfield(L, -4, name); // Stack: co, cl, st
+            lua_pushcclosure(L,
+                             &CFunc::CallProxyFunction<FnType, isChecked>::f,
+                             1); // Stack: co, cl, st, function
+            rawsetfield(L, -4, -3, name); // Stack: co, cl, st
             return *this;
         }
 
+        //--------------------------------------------------------------------------
+        /**
+            Add or replace a member or proxy function known at compile time.
+
+            The resulting lua_CFunction calls the function directly, without
+            an upvalue. Const member functions and proxy functions taking a
+            const object are also added to the const table.
+
+            @tparam FnPtr  The member function or proxy function pointer type.
+            @tparam fp     The member function or proxy function pointer.
+            @param  name   The name of the function.
+            @param  checks Pass luabridge::unchecked to trust the argument types.
+            @returns This class registration object.
+        */
+        template<class FnPtr, FnPtr fp, bool isChecked = detail::checkedCalls>
+        Class<T>& addFunction(char const* name,
+                              CallChecks<isChecked> /*checks*/ = CallChecks<isChecked>())
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            static const std::string GC = "__gc";
+            if (name == GC)
+            {
+                throw std::logic_error(GC + " metamethod registration is forbidden");
+            }
+            CFunc::CallBoundFunctionHelper<FnPtr,
+                                           fp,
+                                           detail::IsConstCallable<FnPtr>::value,
+                                           isChecked>::add(L, name);
+            return *this;
+        }
+
+#ifdef LUABRIDGE_CXX17
+        template<auto fp, bool isChecked = detail::checkedCalls>
+        Class<T>& addFunction(char const* name,
+                              CallChecks<isChecked> checks = CallChecks<isChecked>())
+        {
+            return addFunction<decltype(fp), fp>(name, checks);
+        }
+#endif // LUABRIDGE_CXX17
+
         //--------------------------------------------------------------------------
         /**
             Add or replace a member lua_CFunction.
@@ -946,9 +1508,7 @@ class Namespace : public detail::Registrar
             typedef int (T::*MFP)(lua_State*) const;
             new (lua_newuserdata(L, sizeof(mfp))) MFP(mfp);
             lua_pushcclosure(L, &CFunc::CallConstMemberCFunction<T>::f, 1);
-            lua_pushvalue(L, -1); // Stack: co, cl, st, function, function
-            rawsetfield(L, -4, name); // Stack: co, cl, st, function
-            rawsetfield(L, -4, name); // Stack: co, cl, st
+            rawsetfield(L, -4, -3, name); // Stack: co, cl, st
 
             return *this;
         }
@@ -1304,14 +1864,30 @@ public:
     {
         assert(lua_istable(L, -1)); // Stack: namespace table (ns)
 
-        using FnType = decltype(function);
-        new (lua_newuserdata(L, sizeof(function)))
-            FnType(std::move(function)); // Stack: ns, function userdata (ud)
-        lua_newtable(L); // Stack: ns, ud, ud metatable (mt)
-        lua_pushcfunction(L, &CFunc::gcMetaMethodAny<FnType>); // Stack: ns, ud, mt, gc function
-        rawsetfield(L, -2, "__gc"); // Stack: ns, ud, mt
-        lua_setmetatable(L, -2); // Stack: ns, ud
-        lua_pushcclosure(L, &CFunc::CallProxyFunctor<FnType>::f, 1); // Stack: ns, function
+        CFunc::pushFunctor(L, std::move(function)); // Stack: ns, function
+        rawsetfield(L, -2, name); // Stack: ns
+
+        return *this;
+    }
+
+    //----------------------------------------------------------------------------
+    /**
+        Add or replace a namespace function by a function object.
+
+        The function object, like a lambda, is stored in the Lua closure
+        without a std::function wrapper. Its operator() must not be
+        overloaded. The lambdas convertible to lua_CFunction are added as
+        lua_CFunction.
+    */
+    template<class Functor>
+    typename std::enable_if<std::is_class<Functor>::value &&
+                                !std::is_convertible<Functor, lua_CFunction>::value,
+                            Namespace&>::type
+    addFunction(char const* name, Functor functor)
+    {
+        assert(lua_istable(L, -1)); // Stack: namespace table (ns)
+
+        CFunc::pushFunctor(L, std::move(functor)); // Stack: ns, function
         rawsetfield(L, -2, name); // Stack: ns
 
         return *this;
@@ -1320,20 +1896,59 @@ public:
     //----------------------------------------------------------------------------
     /**
         Add or replace a free function.
+
+        Pass luabridge::unchecked as the last argument to trust the argument
+        types.
     */
-    template<class ReturnType, class... Params>
-    Namespace& addFunction(char const* name, ReturnType (*fp)(Params...))
+    template<class ReturnType, class... Params, bool isChecked = detail::checkedCalls>
+    Namespace& addFunction(char const* name,
+                           ReturnType (*fp)(Params...),
+                           CallChecks<isChecked> = CallChecks<isChecked>())
     {
         assert(lua_istable(L, -1)); // Stack: namespace table (ns)
 
         using FnType = decltype(fp);
         lua_pushlightuserdata(L, reinterpret_cast<void*>(fp)); // Stack: ns, function ptr
-        lua_pushcclosure(L, &CFunc::Call<FnType>::f, 1); // Stack: ns, function
+        lua_pushcclosure(L, &CFunc::Call<FnType, isChecked>::f, 1); // Stack: ns, function
         rawsetfield(L, -2, name); // Stack: ns
 
         return *this;
     }
 
+    //----------------------------------------------------------------------------
+    /**
+        Add or replace a free function known at compile time.
+
+        The resulting lua_CFunction calls the function directly, without
+        an upvalue.
+
+        @tparam FnPtr  The function pointer type.
+        @tparam fp     The function pointer.
+        @param  name   The function name.
+        @param  checks Pass luabridge::unchecked to trust the argument types.
+        @returns This namespace registration object.
+    */
+    template<class FnPtr, FnPtr fp, bool isChecked = detail::checkedCalls>
+    Namespace& addFunction(char const* name,
+                           CallChecks<isChecked> /*checks*/ = CallChecks<isChecked>())
+    {
+        assert(lua_istable(L, -1)); // Stack: namespace table (ns)
+
+        using Thunk = CFunc::CallBound<FnPtr, fp, isChecked>;
+        lua_pushcfunction(L, &Thunk::f); // Stack: ns, function
+        rawsetfield(L, -2, name); // Stack: ns
+
+        return *this;
+    }
+
+#ifdef LUABRIDGE_CXX17
+    template<auto fp, bool isChecked = detail::checkedCalls>
+    Namespace& addFunction(char const* name, CallChecks<isChecked> checks = CallChecks<isChecked>())
+    {
+        return addFunction<decltype(fp), fp>(name, checks);
+    }
+#endif // LUABRIDGE_CXX17
+
 #ifdef _M_IX86 // Windows 32bit only
 
     //----------------------------------------------------------------------------
@@ -1390,14 +2005,15 @@ public:
     /**
         Open a new or existing class for registrations.
 
-        @param name The class name.
+        @param name    The class name.
+        @param options The registration options, used if the class is new.
         @returns A class registration object.
     */
     template<class T>
-    Class<T> beginClass(char const* name)
+    Class<T> beginClass(char const* name, Options options = defaultOptions)
     {
         assertIsActive();
-        return Class<T>(name, *this);
+        return Class<T>(name, *this, options);
     }
 
     //----------------------------------------------------------------------------
@@ -1406,14 +2022,15 @@ public:
         Call deriveClass() only once.
         To continue registrations for the class later, use beginClass().
 
-        @param name The class name.
+        @param name    The class name.
+        @param options The registration options.
         @returns A class registration object.
     */
     template<class Derived, class Base>
-    Class<Derived> deriveClass(char const* name)
+    Class<Derived> deriveClass(char const* name, Options options = defaultOptions)
     {
         assertIsActive();
-        return Class<Derived>(name, *this, detail::getStaticRegistryKey<Base>());
+        return Class<Derived>(name, *this, detail::getStaticRegistryKey<Base>(), options);
     }
 };
 
@@ -0,0 +1,99 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+namespace luabridge {
+
+//------------------------------------------------------------------------------
+/**
+    A set of flags tuning a class registration.
+
+    The options are passed to beginClass() or deriveClass() when the class is
+    registered for the first time. They are stored in the class metatable and
+    are ignored when an existing registration is reopened.
+*/
+class Options
+{
+public:
+    typedef unsigned ValueType;
+
+    constexpr Options() : m_value(0) {}
+
+    constexpr explicit Options(ValueType value) : m_value(value) {}
+
+    constexpr Options operator|(Options rhs) const { return Options(m_value | rhs.m_value); }
+
+    /**
+        Check whether all the flags of another set are present in this one.
+    */
+    constexpr bool test(Options rhs) const { return (m_value & rhs.m_value) == rhs.m_value; }
+
+    constexpr ValueType value() const { return m_value; }
+
+private:
+    ValueType m_value;
+};
+
+/**
+    The default class registration options.
+*/
+constexpr Options defaultOptions = Options();
+
+/**
+    Copy the inherited member functions and properties into the class tables.
+
+    Lookups of inherited members resolve in the class own tables instead of
+    walking the parent chain. The copies are refreshed by endClass() and are
+    dropped while any class of the hierarchy is reopened by beginClass().
+*/
+constexpr Options flattenInheritance = Options(1u << 0);
+
+/**
+    Use a plain table of the member functions as the class __index.
+
+    The Lua VM resolves the method calls without entering a C function.
+    Classes having properties, directly or through a parent class, keep
+    the __index metamethod since the getters need the object. The method
+    table is built by endClass().
+*/
+constexpr Options plainIndexTable = Options(1u << 1);
+
+/**
+    Push the same userdata for the same object pointer.
+
+    The userdata pushed for the pointers and references to the class objects
+    are kept in a weak table, so pushing an object again returns the same
+    userdata while Lua references it. Call luabridge::invalidate() before
+    destroying an object still referenced by Lua.
+*/
+constexpr Options identityCache = Options(1u << 2);
+
+//------------------------------------------------------------------------------
+/**
+    A tag selecting whether a bound function validates its arguments.
+
+    Passed as the last argument of addFunction() or addStaticFunction().
+    The default is set by the LUABRIDGE_UNCHECKED_CALLS macro.
+*/
+template<bool enabled>
+struct CallChecks
+{
+};
+
+/**
+    Validate the object and the arguments of a bound function.
+*/
+constexpr CallChecks<true> checked = CallChecks<true>();
+
+/**
+    Trust the object and the arguments of a bound function.
+
+    The object is retrieved from its userdata and the arithmetic arguments
+    are read without any type check. Passing a value of another type is
+    undefined behavior, it is only asserted in debug builds. This is meant
+    for the functions called by trusted scripts only.
+*/
+constexpr CallChecks<false> unchecked = CallChecks<false>();
+
+} // namespace luabridge
@@ -10,6 +10,7 @@
 #include <LuaBridge/detail/Userdata.h>
 
 #include <string>
+#include <type_traits>
 #ifdef LUABRIDGE_CXX17
 #    include <string_view>
 #endif
@@ -502,6 +503,107 @@ struct Stack<const T*>
     static ReturnType get(lua_State* L, int index) { return Helper::get(L, index); }
 };
 
+namespace detail {
+
+//------------------------------------------------------------------------------
+/**
+    Argument getter of the bound functions.
+
+    The checked getter is the Stack one. The unchecked getter trusts the
+    type of the arithmetic and registered class arguments, asserting it in
+    debug builds, and falls back to the Stack getter for the other types.
+*/
+template<class T, bool isChecked, class Enable = void>
+struct ArgGetter : Stack<T>
+{
+};
+
+template<class T>
+struct ArgGetter<T,
+                 false,
+                 typename std::enable_if<std::is_integral<T>::value &&
+                                         !std::is_same<T, bool>::value &&
+                                         !std::is_same<T, char>::value>::type>
+{
+    static T get(lua_State* L, int index)
+    {
+#if LUA_VERSION_NUM >= 503
+        int isNumber = 0;
+        lua_Integer const value = lua_tointegerx(L, index, &isNumber);
+        assert(isNumber); // The number has an integral representation
+        (void) isNumber;
+        return static_cast<T>(value);
+#else
+        assert(lua_isnumber(L, index));
+        return static_cast<T>(lua_tointeger(L, index));
+#endif
+    }
+};
+
+template<class T>
+struct ArgGetter<T, false, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static T get(lua_State* L, int index)
+    {
+        assert(lua_isnumber(L, index));
+        return static_cast<T>(lua_tonumber(L, index));
+    }
+};
+
+template<class T>
+struct ArgGetter<T const&, false, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    : ArgGetter<T, false>
+{
+};
+
+template<class T>
+struct ArgGetter<
+    T*,
+    false,
+    typename std::enable_if<IsUserdata<T>::value && !std::is_const<T>::value>::type>
+{
+    static T* get(lua_State* L, int index) { return Userdata::getUnchecked<T>(L, index, false); }
+};
+
+template<class T>
+struct ArgGetter<T const*, false, typename std::enable_if<IsUserdata<T>::value>::type>
+{
+    static T const* get(lua_State* L, int index)
+    {
+        return Userdata::getUnchecked<T>(L, index, true);
+    }
+};
+
+template<class T>
+struct ArgGetter<T&,
+                 false,
+                 typename std::enable_if<IsUserdata<T>::value && !std::is_const<T>::value &&
+                                         !TypeTraits::isContainer<T>::value>::type>
+{
+    static T& get(lua_State* L, int index)
+    {
+        T* const t = Userdata::getUnchecked<T>(L, index, false);
+        assert(t != 0);
+        return *t;
+    }
+};
+
+template<class T>
+struct ArgGetter<
+    T const&,
+    false,
+    typename std::enable_if<IsUserdata<T>::value && !TypeTraits::isContainer<T>::value>::type>
+{
+    static T const& get(lua_State* L, int index)
+    {
+        T const* const t = Userdata::getUnchecked<T>(L, index, true);
+        assert(t != 0);
+        return *t;
+    }
+};
+
+} // namespace detail
+
 //------------------------------------------------------------------------------
 /**
  * Push an object onto the Lua stack.
@@ -532,4 +634,16 @@ bool isInstance(lua_State* L, int index)
     return Stack<T>::isInstance(L, index);
 }
 
+//------------------------------------------------------------------------------
+/**
+ * Invalidate the userdata of an object of a class registered with the
+ * identityCache option, before the object is destroyed by C++.
+ * The userdata pushed for the object as any other class are invalidated too.
+ */
+template<class T>
+void invalidate(lua_State* L, T const* object)
+{
+    detail::UserdataPtr::invalidate(L, object);
+}
+
 } // namespace luabridge
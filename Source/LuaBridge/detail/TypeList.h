@@ -29,7 +29,9 @@
 #include <LuaBridge/detail/Stack.h>
 
 #include <string>
+#include <type_traits>
 #include <typeinfo>
+#include <utility>
 
 namespace luabridge {
 
@@ -43,6 +45,7 @@ typedef void None;
 template<typename Head, typename Tail = None>
 struct TypeList
 {
+    typedef Head HeadType;
     typedef Tail TailType;
 };
 
@@ -73,12 +76,64 @@ struct MakeTypeList<>
     using Result = None;
 };
 
+/**
+  Whether a type list has a lua_State* parameter, giving the function access
+  to the Lua stack.
+*/
+template<class List>
+struct HasStateParam
+{
+    static const bool value = std::is_same<typename List::HeadType, lua_State*>::value ||
+                              HasStateParam<typename List::TailType>::value;
+};
+
+template<>
+struct HasStateParam<None>
+{
+    static const bool value = false;
+};
+
+/**
+  The stack index of the first value read by a TypeListValues, and whether
+  the values are checked.
+*/
+template<int Start, bool isChecked>
+struct ArgPosition
+{
+};
+
+/**
+  The type holding a value of a TypeListValues.
+
+  The getters of the references to registered classes return a reference
+  into the userdata, which is held as is instead of copying the object.
+  The other types are held by value.
+*/
+template<typename T>
+struct ArgValue
+{
+    typedef T Type;
+};
+
+template<typename T>
+struct ArgValue<T&>
+{
+    typedef decltype(Stack<T&>::get(std::declval<lua_State*>(), 0)) Type;
+};
+
 /**
   A TypeList with actual values.
 */
 template<typename List>
 struct TypeListValues
 {
+    TypeListValues() {}
+
+    template<int Start, bool isChecked>
+    TypeListValues(lua_State*, ArgPosition<Start, isChecked>)
+    {
+    }
+
     static std::string const tostring(bool) { return ""; }
 };
 
@@ -93,6 +148,16 @@ struct TypeListValues<TypeList<Head, Tail>>
 
     TypeListValues(Head hd_, TypeListValues<Tail> const& tl_) : hd(hd_), tl(tl_) {}
 
+    /**
+      Read the values from the Lua stack in place.
+    */
+    template<int Start, bool isChecked>
+    TypeListValues(lua_State* L, ArgPosition<Start, isChecked>)
+        : hd(ArgGetter<Head, isChecked>::get(L, Start))
+        , tl(L, ArgPosition<Start + 1, isChecked>())
+    {
+    }
+
     static std::string tostring(bool comma = false)
     {
         std::string s;
@@ -107,17 +172,25 @@ struct TypeListValues<TypeList<Head, Tail>>
 };
 
 // Specializations of type/value list for head types that are references and
-// const-references.  We need to handle these specially since we can't count
-// on the referenced object hanging around for the lifetime of the list.
+// const-references. The references to registered classes point into the
+// userdata, which stays on the Lua stack for the lifetime of the list. Other
+// types are converted from Lua values and held by value.
 
 template<typename Head, typename Tail>
 struct TypeListValues<TypeList<Head&, Tail>>
 {
-    Head hd;
+    typename ArgValue<Head&>::Type hd;
     TypeListValues<Tail> tl;
 
     TypeListValues(Head& hd_, TypeListValues<Tail> const& tl_) : hd(hd_), tl(tl_) {}
 
+    template<int Start, bool isChecked>
+    TypeListValues(lua_State* L, ArgPosition<Start, isChecked>)
+        : hd(ArgGetter<Head&, isChecked>::get(L, Start))
+        , tl(L, ArgPosition<Start + 1, isChecked>())
+    {
+    }
+
     static std::string const tostring(bool comma = false)
     {
         std::string s;
@@ -134,11 +207,18 @@ struct TypeListValues<TypeList<Head&, Tail>>
 template<typename Head, typename Tail>
 struct TypeListValues<TypeList<Head const&, Tail>>
 {
-    Head hd;
+    typename ArgValue<Head const&>::Type hd;
     TypeListValues<Tail> tl;
 
     TypeListValues(Head const& hd_, const TypeListValues<Tail>& tl_) : hd(hd_), tl(tl_) {}
 
+    template<int Start, bool isChecked>
+    TypeListValues(lua_State* L, ArgPosition<Start, isChecked>)
+        : hd(ArgGetter<Head const&, isChecked>::get(L, Start))
+        , tl(L, ArgPosition<Start + 1, isChecked>())
+    {
+    }
+
     static std::string const tostring(bool comma = false)
     {
         std::string s;
@@ -157,23 +237,23 @@ struct TypeListValues<TypeList<Head const&, Tail>>
   Subclass of a TypeListValues constructable from the Lua stack.
 */
 
-template<typename List, int Start = 1>
+template<typename List, int Start = 1, bool isChecked = true>
 struct ArgList
 {
 };
 
-template<int Start>
-struct ArgList<None, Start> : public TypeListValues<None>
+template<int Start, bool isChecked>
+struct ArgList<None, Start, isChecked> : public TypeListValues<None>
 {
     ArgList(lua_State*) {}
 };
 
-template<typename Head, typename Tail, int Start>
-struct ArgList<TypeList<Head, Tail>, Start> : public TypeListValues<TypeList<Head, Tail>>
+template<typename Head, typename Tail, int Start, bool isChecked>
+struct ArgList<TypeList<Head, Tail>, Start, isChecked>
+    : public TypeListValues<TypeList<Head, Tail>>
 {
     ArgList(lua_State* L)
-        : TypeListValues<TypeList<Head, Tail>>(Stack<Head>::get(L, Start),
-                                               ArgList<Tail, Start + 1>(L))
+        : TypeListValues<TypeList<Head, Tail>>(L, ArgPosition<Start, isChecked>())
     {
     }
 };
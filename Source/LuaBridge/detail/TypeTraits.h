@@ -7,6 +7,8 @@
 
 #include <LuaBridge/detail/Config.h>
 
+#include <cstddef>
+#include <tuple>
 
 namespace luabridge {
 
@@ -106,6 +108,47 @@ struct TypeTraits
     /**@}*/
 };
 
+//------------------------------------------------------------------------------
+/**
+    A compile time sequence of indices, like the C++14 std::index_sequence.
+*/
+template<std::size_t... Is>
+struct IndexSequence
+{
+};
+
+/**
+    Make the sequence of indices 0 to N - 1.
+*/
+/** @{ */
+template<std::size_t N, std::size_t... Is>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Is...>
+{
+};
+
+template<std::size_t... Is>
+struct MakeIndexSequence<0, Is...> : IndexSequence<Is...>
+{
+};
+/** @} */
+
+/**
+    Determine whether T is a std::tuple.
+*/
+/** @{ */
+template<class T>
+struct IsTuple
+{
+    static bool const value = false;
+};
+
+template<class... Ts>
+struct IsTuple<std::tuple<Ts...>>
+{
+    static bool const value = true;
+};
+/** @} */
+
 } // namespace detail
 
 } // namespace luabridge
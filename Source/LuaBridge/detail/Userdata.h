@@ -6,10 +6,17 @@
 #pragma once
 
 #include <LuaBridge/detail/ClassInfo.h>
+#include <LuaBridge/detail/HandleMap.h>
+#include <LuaBridge/detail/LuaHelpers.h>
 #include <LuaBridge/detail/TypeTraits.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace luabridge {
 
@@ -29,21 +36,69 @@ namespace detail {
     3. Scripts cannot set the metatable on a userdata.
 */
 
+class UserdataContainer;
+
 /**
   Interface to a class pointer retrievable from a userdata.
+
+  The header has no virtual table: it only holds the class identity, whose
+  low bits tell how the object is stored. A value follows the header at its
+  alignment, the other kinds of userdata hold a pointer to the object, see
+  UserdataReference. The userdata is destroyed by the __gc metamethod of its
+  class, see destroy().
 */
 class Userdata
 {
+    friend class UserdataContainer;
+    friend class UserdataHandle;
+
 protected:
-    void* m_p; // subclasses must set this
+    /**
+      How the object of a userdata is stored.
+    */
+    enum Kind
+    {
+        valueKind = 0, // UserdataValue, the object is in the userdata
+        pointerKind = 1, // UserdataPtr, the object is owned by C++
+        containerKind = 2, // UserdataShared, the object is owned by a container
+        handleKind = 3 // UserdataHandle, the object is in the slot of a handle map
+    };
+
+    static std::uintptr_t const kindMask = 3;
+
+    static_assert(alignof(ClassInfo) > kindMask, "No room for the kind in a ClassInfo pointer");
+
+    std::uintptr_t m_info; // the ClassInfo set by setClass, the Kind in the low bits
+
+    explicit Userdata(Kind kind) : m_info(kind) {}
 
-    Userdata() : m_p(0) {}
+    Kind getKind() const { return static_cast<Kind>(m_info & kindMask); }
+
+    ClassInfo const* getClassInfo() const
+    {
+        return reinterpret_cast<ClassInfo const*>(m_info & ~kindMask);
+    }
 
     //--------------------------------------------------------------------------
     /**
       Get an untyped pointer to the contained class.
+
+      Returns a null pointer for a stale handle or an invalidated pointer.
     */
-    void* getPointer() { return m_p; }
+    void* getPointer();
+
+    /**
+      Get the storage of a value, following the header at the alignment of
+      its class.
+    */
+    void* getValueObject()
+    {
+        std::uintptr_t const storage = reinterpret_cast<std::uintptr_t>(this + 1);
+        std::uintptr_t const alignment = getClassInfo()->valueAlignment;
+        return reinterpret_cast<void*>((storage + alignment - 1) & ~(alignment - 1));
+    }
+
+    void* getHandleObject();
 
 private:
     //--------------------------------------------------------------------------
@@ -59,6 +114,40 @@ private:
         return static_cast<Userdata*>(lua_touserdata(L, lua_absindex(L, index)));
     }
 
+    //--------------------------------------------------------------------------
+    /**
+      Retrieve a Userdata created by LuaBridge on the stack.
+
+      The userdata header can only be trusted once its metatable is known
+      to be one of our class or const tables, which is checked with a
+      single table lookup. Returns a null pointer for any other value.
+    */
+    static Userdata* getUserdata(lua_State* L, int index)
+    {
+        if (lua_type(L, index) != LUA_TUSERDATA || !lua_getmetatable(L, index))
+        {
+            return 0;
+        }
+
+        if (!lua_istable(L, -1))
+        {
+            lua_pop(L, 1); // Stack: -
+            return 0;
+        }
+
+        lua_rawgetp(L, -1, getClassInfoKey()); // Stack: object metatable, info | nil
+        void const* const info = lua_touserdata(L, -1);
+        lua_pop(L, 2); // Stack: -
+        if (info == 0)
+        {
+            return 0;
+        }
+
+        Userdata* const ud = static_cast<Userdata*>(lua_touserdata(L, index));
+        assert(ud->getClassInfo() == info);
+        return ud;
+    }
+
     //--------------------------------------------------------------------------
     /**
       Validate and retrieve a Userdata on the stack.
@@ -72,101 +161,48 @@ private:
                               int index,
                               void const* registryConstKey,
                               void const* registryClassKey,
+                              int classId,
                               bool canBeConst)
     {
         index = lua_absindex(L, index);
 
-        lua_getmetatable(L, index); // Stack: object metatable (ot) | nil
-        if (!lua_istable(L, -1))
+        Userdata* const ud = getUserdata(L, index);
+        if (ud == 0)
         {
             lua_rawgetp(
                 L, LUA_REGISTRYINDEX, registryClassKey); // Stack: registry metatable (rt) | nil
             return throwBadArg(L, index);
         }
 
-        lua_rawgetp(L, -1, getConstKey()); // Stack: ot | nil, const table (co) | nil
-        assert(lua_istable(L, -1) || lua_isnil(L, -1));
+        bool const isConst = ud->getClassInfo()->isConst;
+        if (ud->getClassInfo()->isDerivedFrom(classId) && (canBeConst || !isConst))
+        {
+            return ud;
+        }
 
-        // If const table is NOT present, object is const. Use non-const registry table
-        // if object cannot be const, so constness validation is done automatically.
+        // Use non-const registry table if object cannot be const,
+        // so that the error message reports the constness violation.
         // E.g. nonConstFn (constObj)
         // -> canBeConst = false, isConst = true
         // -> 'Class' registry table, 'const Class' object table
         // -> 'expected Class, got const Class'
-        bool isConst = lua_isnil(L, -1); // Stack: ot | nil, nil, rt
-        if (isConst && canBeConst)
-        {
-            lua_rawgetp(L, LUA_REGISTRYINDEX, registryConstKey); // Stack: ot, nil, rt
-        }
-        else
-        {
-            lua_rawgetp(L, LUA_REGISTRYINDEX, registryClassKey); // Stack: ot, co, rt
-        }
-
-        lua_insert(L, -3); // Stack: rt, ot, co | nil
-        lua_pop(L, 1); // Stack: rt, ot
-
-        for (;;)
-        {
-            if (lua_rawequal(L, -1, -2)) // Stack: rt, ot
-            {
-                lua_pop(L, 2); // Stack: -
-                return static_cast<Userdata*>(lua_touserdata(L, index));
-            }
-
-            // Replace current metatable with it's base class.
-            lua_rawgetp(L, -1, getParentKey()); // Stack: rt, ot, parent ot (pot) | nil
-
-            if (lua_isnil(L, -1)) // Stack: rt, ot, nil
-            {
-                // Drop the object metatable because it may be some parent metatable
-                lua_pop(L, 2); // Stack: rt
-                return throwBadArg(L, index);
-            }
-
-            lua_remove(L, -2); // Stack: rt, pot
-        }
-
-        // no return
+        lua_rawgetp(L,
+                    LUA_REGISTRYINDEX,
+                    isConst && canBeConst ? registryConstKey
+                                          : registryClassKey); // Stack: rt | nil
+        return throwBadArg(L, index);
     }
 
-    static bool isInstance(lua_State* L, int index, void const* registryClassKey)
+    static bool isClass(lua_State* L, int index, int classId, bool canBeConst)
     {
-        index = lua_absindex(L, index);
-
-        int result = lua_getmetatable(L, index); // Stack: object metatable (ot) | nothing
-        if (result == 0)
-        {
-            return false; // Nothing was pushed on the stack
-        }
-        if (!lua_istable(L, -1))
-        {
-            lua_pop(L, 1); // Stack: -
-            return false;
-        }
-
-        lua_rawgetp(L, LUA_REGISTRYINDEX, registryClassKey); // Stack: ot, rt
-        lua_insert(L, -2); // Stack: rt, ot
-
-        for (;;)
-        {
-            if (lua_rawequal(L, -1, -2)) // Stack: rt, ot
-            {
-                lua_pop(L, 2); // Stack: -
-                return true;
-            }
-
-            // Replace current metatable with it's base class.
-            lua_rawgetp(L, -1, getParentKey()); // Stack: rt, ot, parent ot (pot) | nil
-
-            if (lua_isnil(L, -1)) // Stack: rt, ot, nil
-            {
-                lua_pop(L, 3); // Stack: -
-                return false;
-            }
+        Userdata* const ud = getUserdata(L, index);
+        return ud != 0 && ud->getClassInfo()->isDerivedFrom(classId) &&
+               (canBeConst || !ud->getClassInfo()->isConst);
+    }
 
-            lua_remove(L, -2); // Stack: rt, pot
-        }
+    static bool isInstance(lua_State* L, int index, int classId)
+    {
+        return isClass(L, index, classId, false);
     }
 
     static Userdata* throwBadArg(lua_State* L, int index)
@@ -207,7 +243,74 @@ private:
     }
 
 public:
-    virtual ~Userdata() {}
+    //--------------------------------------------------------------------------
+    /**
+      Set the metatable of a new userdata on the top of the stack.
+
+      The class identity is copied into the userdata header.
+
+      @param L           A Lua state.
+      @param ud          The userdata on the top of the stack.
+      @param registryKey The registry key of the class or const table.
+      @throws std::logic_error if the class is not registered.
+    */
+    static void setClass(lua_State* L, Userdata* ud, void const* registryKey)
+    {
+        pushRegistryTable(L, registryKey); // Stack: ud, rt
+        setClassTable(L, ud); // Stack: ud
+    }
+
+protected:
+    //--------------------------------------------------------------------------
+    /**
+      Push the class or const table registered with a key.
+
+      @throws std::logic_error if the class is not registered.
+    */
+    static void pushRegistryTable(lua_State* L, void const* registryKey)
+    {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, registryKey); // Stack: rt | nil
+        if (!lua_istable(L, -1))
+        {
+            lua_pop(L, 1); // possibly: a nil
+            throw std::logic_error("The class is not registered in LuaBridge");
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+      Set the class or const table on the top of the stack as the metatable
+      of a new userdata just below it, and pop the table.
+    */
+    static void setClassTable(lua_State* L, Userdata* ud)
+    {
+        setClassTable(L, ud, getTableClassInfo(L));
+    }
+
+    /**
+      Set the class or const table on the top of the stack, whose identity
+      is already known, as the metatable of a new userdata just below it.
+    */
+    static void setClassTable(lua_State* L, Userdata* ud, ClassInfo const* info)
+    {
+        std::uintptr_t const bits = reinterpret_cast<std::uintptr_t>(info);
+        assert(bits != 0 && (bits & kindMask) == 0);
+        ud->m_info = bits | (ud->m_info & kindMask);
+        lua_setmetatable(L, -2); // Stack: ud
+    }
+
+    /**
+      Get the identity of the class or const table on the top of the stack.
+    */
+    static ClassInfo const* getTableClassInfo(lua_State* L)
+    {
+        lua_rawgetp(L, -1, getClassInfoKey()); // Stack: rt, info
+        ClassInfo const* const info = static_cast<ClassInfo const*>(lua_touserdata(L, -1));
+        lua_pop(L, 1); // Stack: rt
+        return info;
+    }
+
+public:
 
     //--------------------------------------------------------------------------
     /**
@@ -225,6 +328,20 @@ public:
         return getExactClass(L, index, detail::getClassRegistryKey<T>());
     }
 
+    //--------------------------------------------------------------------------
+    /**
+      Destroy a userdata of a class, from its __gc metamethod.
+
+      A value of the class is destroyed in place, a container releases its
+      object, a handle releases the slots of its map and a pointer owned by
+      C++ is left alone.
+
+      @tparam T  The class of the metatable holding the __gc metamethod.
+      @param  ud The userdata to destroy.
+    */
+    template<class T>
+    static void destroy(Userdata* ud);
+
     //--------------------------------------------------------------------------
     /**
       Get a pointer to the class from the Lua stack.
@@ -243,18 +360,95 @@ public:
         if (lua_isnil(L, index))
             return 0;
 
-        return static_cast<T*>(getClass(L,
-                                        index,
-                                        detail::getConstRegistryKey<T>(),
-                                        detail::getClassRegistryKey<T>(),
-                                        canBeConst)
-                                   ->getPointer());
+        return static_cast<T*>(getUntyped(L,
+                                          index,
+                                          detail::getConstRegistryKey<T>(),
+                                          detail::getClassRegistryKey<T>(),
+                                          detail::getClassId<T>(),
+                                          canBeConst));
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+      Get an untyped pointer to the class from the Lua stack.
+      If the object is not the class or a subclass, or it violates the
+      const-ness, a Lua error is raised.
+
+      This is the non-template part of get(), for the accessors shared by
+      several classes.
+    */
+    static void* getUntyped(lua_State* L,
+                            int index,
+                            void const* registryConstKey,
+                            void const* registryClassKey,
+                            int classId,
+                            bool canBeConst)
+    {
+        void* const p =
+            getClass(L, index, registryConstKey, registryClassKey, classId, canBeConst)
+                ->getPointer();
+        if (p == 0)
+        {
+            luaL_error(L, "The object was invalidated");
+        }
+        return p;
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+      Get a pointer to the class from the Lua stack, trusting its type.
+
+      This is used by the unchecked calls. The class and the const-ness are
+      only asserted, any other value than a LuaBridge userdata leads to
+      undefined behavior in release builds.
+
+      @tparam T          A registered user class.
+      @param  L          A Lua state.
+      @param  index      The index of an item on the Lua stack.
+      @param  canBeConst Whether the object is allowed to be const.
+      @returns A pointer to the object, or a null pointer for nil.
+    */
+    template<class T>
+    static T* getUnchecked(lua_State* L, int index, bool canBeConst)
+    {
+        return static_cast<T*>(
+            getUncheckedUntyped(L, index, detail::getClassId<T>(), canBeConst));
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+      Get an untyped pointer to the class from the Lua stack, trusting its
+      type.
+
+      This is the non-template part of getUnchecked(), for the accessors
+      shared by several classes. The generation of a handle is still
+      checked, raising a Lua error for a dead object.
+    */
+    static void* getUncheckedUntyped(lua_State* L, int index, int classId, bool canBeConst)
+    {
+        assert(lua_isnil(L, index) || isClass(L, index, classId, canBeConst));
+        (void)classId;
+        (void)canBeConst;
+
+        Userdata* const ud = static_cast<Userdata*>(lua_touserdata(L, index));
+        if (ud == 0)
+        {
+            return 0;
+        }
+
+        void* const p = ud->getPointer();
+        if (p == 0 && ud->getKind() == handleKind)
+        {
+            luaL_error(L, "The object was invalidated");
+        }
+        assert(p != 0); // An invalidated pointer
+        return p;
     }
 
     template<class T>
     static bool isInstance(lua_State* L, int index)
     {
-        return isInstance(L, index, detail::getClassRegistryKey<T>());
+        return isInstance(L, index, detail::getClassId<T>());
     }
 };
 
@@ -272,43 +466,37 @@ private:
     UserdataValue(UserdataValue<T> const&);
     UserdataValue<T> operator=(UserdataValue<T> const&);
 
-    char m_storage[sizeof(T)];
+    /**
+      The extra bytes allocated to align the object when its alignment is
+      stricter than the one of the userdata memory.
+    */
+    static std::size_t const padding =
+        alignof(T) > alignof(Userdata) ? alignof(T) - alignof(Userdata) : 0;
 
 private:
     /**
       Used for placement construction.
     */
-    UserdataValue() { m_p = 0; }
-
-    ~UserdataValue()
-    {
-        if (getPointer() != 0)
-        {
-            getObject()->~T();
-        }
-    }
+    UserdataValue() : Userdata(valueKind) {}
 
 public:
     /**
       Push a T via placement new.
 
       The caller is responsible for calling placement new using the
-      returned uninitialized storage.
+      returned uninitialized storage, then commit(). Until then the class
+      table and the userdata without metatable are on the stack, so an
+      object failing to construct is never destroyed.
 
       @param L A Lua state.
       @returns An object referring to the newly created userdata value.
+      @throws std::logic_error if the class is not registered.
     */
     static UserdataValue<T>* place(lua_State* const L)
     {
-        UserdataValue<T>* const ud =
-            new (lua_newuserdata(L, sizeof(UserdataValue<T>))) UserdataValue<T>();
-        lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getClassRegistryKey<T>());
-        if (!lua_istable(L, -1))
-        {
-            throw std::logic_error("The class is not registered in LuaBridge");
-        }
-        lua_setmetatable(L, -2);
-        return ud;
+        pushRegistryTable(L, detail::getClassRegistryKey<T>()); // Stack: rt
+        return new (lua_newuserdata(L, sizeof(UserdataValue<T>) + padding + sizeof(T)))
+            UserdataValue<T>(); // Stack: rt, ud
     }
 
     /**
@@ -323,30 +511,81 @@ public:
     {
         UserdataValue<T>* ud = place(L);
         new (ud->getObject()) U(u);
-        ud->commit();
+        ud->commit(L);
+    }
+
+    /**
+      Push T via move construction.
+
+      @param L A Lua state.
+      @param t An object to move from.
+    */
+    static inline void push(lua_State* const L, T&& t)
+    {
+        UserdataValue<T>* ud = place(L);
+        new (ud->getObject()) T(std::move(t));
+        ud->commit(L);
     }
 
     /**
-      Confirm object construction.
+      Confirm object construction, setting the metatable of the userdata.
+
+      @param L A Lua state with the class table and this userdata on the top
+               of the stack, as left by place().
     */
-    void commit() { m_p = getObject(); }
+    void commit(lua_State* const L)
+    {
+        lua_insert(L, -2); // Stack: ud, rt
+        setClassTable(L, this); // Stack: ud
+    }
 
+    /**
+      Get the storage of the object, following the header at its alignment.
+    */
     T* getObject()
     {
-        // If this fails to compile it means you forgot to provide
-        // a Container specialization for your container!
-        //
-        return reinterpret_cast<T*>(&m_storage[0]);
+        std::uintptr_t const storage = reinterpret_cast<std::uintptr_t>(this + 1);
+        std::uintptr_t const alignment = alignof(T);
+        return reinterpret_cast<T*>((storage + alignment - 1) & ~(alignment - 1));
     }
 };
 
+//----------------------------------------------------------------------------
+/**
+  Base of the userdata referring to an object stored elsewhere.
+*/
+class UserdataReference : public Userdata
+{
+protected:
+    explicit UserdataReference(Kind kind) : Userdata(kind), m_p(0) {}
+
+    void* m_p; // subclasses must set this
+
+    friend class Userdata;
+};
+
+inline void* Userdata::getPointer()
+{
+    switch (getKind())
+    {
+    case valueKind:
+        return getValueObject();
+
+    case handleKind:
+        return getHandleObject();
+
+    default:
+        return static_cast<UserdataReference*>(this)->m_p;
+    }
+}
+
 //----------------------------------------------------------------------------
 /**
   Wraps a pointer to a class object inside a Lua userdata.
 
   The lifetime of the object is managed by C++.
 */
-class UserdataPtr : public Userdata
+class UserdataPtr : public UserdataReference
 {
 private:
     UserdataPtr(UserdataPtr const&);
@@ -354,20 +593,70 @@ private:
 
 private:
     /** Push a pointer to object using metatable key.
+
+        If the class has an identity cache, the userdata already pushed for
+        the same object is reused. The classes without one skip the lookup.
      */
     static void push(lua_State* L, const void* p, void const* const key)
     {
-        new (lua_newuserdata(L, sizeof(UserdataPtr))) UserdataPtr(const_cast<void*>(p));
-        lua_rawgetp(L, LUA_REGISTRYINDEX, key);
-        if (!lua_istable(L, -1))
+        pushRegistryTable(L, key); // Stack: rt
+        ClassInfo const* const info = getTableClassInfo(L);
+        if (!info->hasIdentityCache)
         {
-            lua_pop(L, 1); // possibly: a nil
-            throw std::logic_error("The class is not registered in LuaBridge");
+            UserdataPtr* const ud = new (lua_newuserdata(L, sizeof(UserdataPtr)))
+                UserdataPtr(const_cast<void*>(p)); // Stack: rt, ud
+            lua_insert(L, -2); // Stack: ud, rt
+            setClassTable(L, ud, info); // Stack: ud
+            return;
+        }
+
+        lua_rawgetp(L, -1, getIdentityCacheKey()); // Stack: rt, cache
+        lua_rawgetp(L, -1, p); // Stack: rt, cache, ud | nil
+        if (!lua_isnil(L, -1))
+        {
+            lua_replace(L, -3); // Stack: ud, cache
+            lua_pop(L, 1); // Stack: ud
+            return;
+        }
+
+        lua_pop(L, 1); // Stack: rt, cache
+        UserdataPtr* const ud = new (lua_newuserdata(L, sizeof(UserdataPtr)))
+            UserdataPtr(const_cast<void*>(p)); // Stack: rt, cache, ud
+        lua_pushvalue(L, -1); // Stack: rt, cache, ud, ud
+        lua_rawsetp(L, -3, p); // cache [p] = ud. Stack: rt, cache, ud
+        lua_replace(L, -2); // Stack: rt, ud
+        lua_insert(L, -2); // Stack: ud, rt
+        setClassTable(L, ud, info); // Stack: ud
+    }
+
+    /** Detach the cached userdata of an object from all the identity caches.
+     */
+    static void invalidate(lua_State* L, const void* p)
+    {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, getIdentityCachesKey()); // Stack: list | nil
+        if (lua_istable(L, -1))
+        {
+            int const count = get_rawlength(L, -1);
+            for (int i = 1; i <= count; ++i)
+            {
+                lua_rawgeti(L, -1, i); // Stack: list, cache
+                lua_rawgetp(L, -1, p); // Stack: list, cache, ud | nil
+                UserdataPtr* const ud = static_cast<UserdataPtr*>(lua_touserdata(L, -1));
+                lua_pop(L, 1); // Stack: list, cache
+                if (ud != 0)
+                {
+                    assert(ud->getKind() == pointerKind);
+                    ud->m_p = 0;
+                    lua_pushnil(L); // Stack: list, cache, nil
+                    lua_rawsetp(L, -2, p); // cache [p] = nil. Stack: list, cache
+                }
+                lua_pop(L, 1); // Stack: list
+            }
         }
-        lua_setmetatable(L, -2);
+        lua_pop(L, 1); // Stack: -
     }
 
-    explicit UserdataPtr(void* const p)
+    explicit UserdataPtr(void* const p) : UserdataReference(pointerKind)
     {
         m_p = p;
 
@@ -406,8 +695,124 @@ public:
         else
             lua_pushnil(L);
     }
+
+    /** Forget the userdata cached for an object about to be destroyed.
+
+      The userdata pushed for the same address as any class, const or not,
+      are detached, those still referenced by Lua raise an error when used.
+
+      @tparam T A user registered class.
+      @param  L A Lua state.
+      @param  p A pointer to the user class instance.
+    */
+    template<class T>
+    static void invalidate(lua_State* const L, T const* const p)
+    {
+        invalidate(L, static_cast<void const*>(p));
+    }
+};
+
+//============================================================================
+/**
+  Wraps a handle to a class object of a HandleMap.
+
+  The lifetime of the object is managed by C++. The userdata shares the
+  ownership of the slots of the map and holds the slot index, the object is
+  returned while the slot has the same generation as the handle.
+*/
+class UserdataHandle : public Userdata
+{
+private:
+    UserdataHandle(UserdataHandle const&);
+    UserdataHandle& operator=(UserdataHandle const&);
+
+    explicit UserdataHandle(std::shared_ptr<HandleSlots> const& slots,
+                            std::uint32_t index,
+                            std::uint32_t generation)
+        : Userdata(handleKind), m_slots(slots), m_index(index), m_generation(generation)
+    {
+    }
+
+    ~UserdataHandle() {}
+
+    std::shared_ptr<HandleSlots> const m_slots;
+    std::uint32_t const m_index;
+    std::uint32_t const m_generation;
+
+    friend class Userdata;
+
+public:
+    /** Push a handle to object.
+
+      @tparam T A user registered class, possibly const.
+      @param  L A Lua state.
+      @param  h A handle to the user class instance.
+      @throws std::logic_error if the class is not registered.
+    */
+    template<class T>
+    static void push(lua_State* const L, Handle<T> const& h)
+    {
+        typedef typename TypeTraits::removeConst<T>::Type U;
+
+        if (!h.getSlots())
+        {
+            lua_pushnil(L);
+            return;
+        }
+
+        // The table is looked up first so that a failure leaks no reference
+        pushRegistryTable(L,
+                          TypeTraits::isConst<T>::value
+                              ? getConstRegistryKey<U>()
+                              : getClassRegistryKey<U>()); // Stack: rt
+        UserdataHandle* const ud = new (lua_newuserdata(L, sizeof(UserdataHandle)))
+            UserdataHandle(h.getSlots(), h.getIndex(), h.getGeneration()); // Stack: rt, ud
+        lua_insert(L, -2); // Stack: ud, rt
+        setClassTable(L, ud); // Stack: ud
+    }
+
+    /** Get a handle to object from the Lua stack.
+
+      A Lua error is raised if the object is not the class or a subclass, or
+      if it was not pushed as a handle. A stale handle is returned as is.
+
+      @tparam T     A user registered class, possibly const.
+      @param  L     A Lua state.
+      @param  index The index of an item on the Lua stack.
+      @returns A handle, null for nil.
+    */
+    template<class T>
+    static Handle<T> get(lua_State* const L, int index)
+    {
+        typedef typename TypeTraits::removeConst<T>::Type U;
+
+        if (lua_isnil(L, index))
+        {
+            return Handle<T>();
+        }
+
+        Userdata* const ud = getClass(L,
+                                      index,
+                                      getConstRegistryKey<U>(),
+                                      getClassRegistryKey<U>(),
+                                      getClassId<U>(),
+                                      TypeTraits::isConst<T>::value);
+        if (ud->getKind() != handleKind)
+        {
+            luaL_error(L, "The object is not referred to by a handle");
+        }
+
+        UserdataHandle const* const handle = static_cast<UserdataHandle*>(ud);
+        return Handle<T>(handle->m_slots, handle->m_index, handle->m_generation);
+    }
 };
 
+inline void* Userdata::getHandleObject()
+{
+    UserdataHandle const* const ud = static_cast<UserdataHandle*>(this);
+    return ud->m_slots->getObject(ud->m_index, ud->m_generation);
+}
+
 //============================================================================
 /**
   Wraps a container that references a class object.
@@ -415,8 +820,45 @@ public:
   The template argument C is the container type, ContainerTraits must be
   specialized on C or else a compile error will result.
 */
+class UserdataContainer : public UserdataReference
+{
+protected:
+    typedef void (*Destroy)(UserdataContainer* ud);
+
+    explicit UserdataContainer(Destroy destroy)
+        : UserdataReference(containerKind), m_destroy(destroy)
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+      Get a container userdata created with a destroy function.
+
+      @param L       A Lua state.
+      @param index   The index of a LuaBridge userdata on the Lua stack.
+      @param destroy The destroy function of the expected container type.
+      @returns The userdata or a null pointer for another kind of userdata.
+    */
+    static UserdataContainer* getContainer(lua_State* L, int index, Destroy destroy)
+    {
+        Userdata* const ud = static_cast<Userdata*>(lua_touserdata(L, index));
+        if (ud == 0 || ud->getKind() != containerKind)
+        {
+            return 0;
+        }
+
+        UserdataContainer* const container = static_cast<UserdataContainer*>(ud);
+        return container->m_destroy == destroy ? container : 0;
+    }
+
+private:
+    friend class Userdata;
+
+    Destroy const m_destroy;
+};
+
 template<class C>
-class UserdataShared : public Userdata
+class UserdataShared : public UserdataContainer
 {
 private:
     UserdataShared(UserdataShared<C> const&);
@@ -429,6 +871,11 @@ private:
 private:
     ~UserdataShared() {}
 
+    static void destroy(UserdataContainer* ud)
+    {
+        static_cast<UserdataShared<C>*>(ud)->~UserdataShared();
+    }
+
 public:
     /**
       Construct from a container to the class or a derived class.
@@ -437,7 +884,7 @@ public:
       @param  u A container object reference.
     */
     template<class U>
-    explicit UserdataShared(U const& u) : m_c(u)
+    explicit UserdataShared(U const& u) : UserdataContainer(&destroy), m_c(u)
     {
         m_p = const_cast<void*>(reinterpret_cast<void const*>((ContainerTraits<C>::get(m_c))));
     }
@@ -449,12 +896,50 @@ public:
       @param  u A container object pointer.
     */
     template<class U>
-    explicit UserdataShared(U* u) : m_c(u)
+    explicit UserdataShared(U* u) : UserdataContainer(&destroy), m_c(u)
     {
         m_p = const_cast<void*>(reinterpret_cast<void const*>((ContainerTraits<C>::get(m_c))));
     }
 };
 
+//----------------------------------------------------------------------------
+
+template<class T>
+inline void destroyValue(void* object, std::true_type)
+{
+    static_cast<T*>(object)->~T();
+}
+
+template<class T>
+inline void destroyValue(void*, std::false_type)
+{
+    // A class without a public destructor cannot be pushed by value
+    assert(false);
+}
+
+template<class T>
+inline void Userdata::destroy(Userdata* ud)
+{
+    switch (ud->getKind())
+    {
+    case valueKind:
+        destroyValue<T>(ud->getValueObject(),
+                        std::integral_constant<bool, std::is_destructible<T>::value>());
+        break;
+
+    case containerKind:
+        static_cast<UserdataContainer*>(ud)->m_destroy(static_cast<UserdataContainer*>(ud));
+        break;
+
+    case handleKind:
+        static_cast<UserdataHandle*>(ud)->~UserdataHandle();
+        break;
+
+    default:
+        break;
+    }
+}
+
 //----------------------------------------------------------------------------
 //
 // SFINAE helpers.
@@ -470,11 +955,9 @@ struct UserdataSharedHelper
     {
         if (ContainerTraits<C>::get(c) != 0)
         {
-            new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(c);
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getClassRegistryKey<T>());
-            // If this goes off it means the class T is unregistered!
-            assert(lua_istable(L, -1));
-            lua_setmetatable(L, -2);
+            Userdata* const ud =
+                new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(c);
+            Userdata::setClass(L, ud, getClassRegistryKey<T>());
         }
         else
         {
@@ -486,11 +969,9 @@ struct UserdataSharedHelper
     {
         if (t)
         {
-            new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(t);
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getClassRegistryKey<T>());
-            // If this goes off it means the class T is unregistered!
-            assert(lua_istable(L, -1));
-            lua_setmetatable(L, -2);
+            Userdata* const ud =
+                new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(t);
+            Userdata::setClass(L, ud, getClassRegistryKey<T>());
         }
         else
         {
@@ -509,11 +990,9 @@ struct UserdataSharedHelper<C, true>
     {
         if (ContainerTraits<C>::get(c) != 0)
         {
-            new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(c);
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getConstRegistryKey<T>());
-            // If this goes off it means the class T is unregistered!
-            assert(lua_istable(L, -1));
-            lua_setmetatable(L, -2);
+            Userdata* const ud =
+                new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(c);
+            Userdata::setClass(L, ud, getConstRegistryKey<T>());
         }
         else
         {
@@ -525,11 +1004,9 @@ struct UserdataSharedHelper<C, true>
     {
         if (t)
         {
-            new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(t);
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getConstRegistryKey<T>());
-            // If this goes off it means the class T is unregistered!
-            assert(lua_istable(L, -1));
-            lua_setmetatable(L, -2);
+            Userdata* const ud =
+                new (lua_newuserdata(L, sizeof(UserdataShared<C>))) UserdataShared<C>(t);
+            Userdata::setClass(L, ud, getConstRegistryKey<T>());
         }
         else
         {
@@ -543,9 +1020,10 @@ struct UserdataSharedHelper<C, true>
 
   The container controls the object lifetime. Typically this will be a
   lifetime shared by C++ and Lua using a reference count. Because of type
-  erasure, containers like std::shared_ptr will not work. Containers must
-  either be of the intrusive variety, or in the style of the RefCountedPtr
-  type provided by LuaBridge (that uses a global hash table).
+  erasure, the containers recreated from a raw pointer must either be of the
+  intrusive variety, or in the style of the RefCountedPtr type provided by
+  LuaBridge (that uses a global hash table). The std::shared_ptr support in
+  Memory.h keeps the control block in the userdata instead.
 */
 template<class C, bool byContainer>
 struct StackHelper
@@ -573,6 +1051,8 @@ struct StackHelper<T, false>
 {
     static inline void push(lua_State* L, T const& t) { UserdataValue<T>::push(L, t); }
 
+    static inline void push(lua_State* L, T&& t) { UserdataValue<T>::push(L, std::move(t)); }
+
     static inline T const& get(lua_State* L, int index)
     {
         const T* const t = Userdata::get<T>(L, index, true);
@@ -605,7 +1085,10 @@ struct RefStackHelper
 
     typedef typename TypeTraits::removeConst<typename ContainerTraits<C>::Type>::Type T;
 
-    static return_type get(lua_State* L, int index) { return Userdata::get<T>(L, index, true); }
+    static return_type get(lua_State* L, int index, bool /*canBeConst*/)
+    {
+        return Userdata::get<T>(L, index, true);
+    }
 };
 
 template<class T>
@@ -615,9 +1098,9 @@ struct RefStackHelper<T, false>
 
     static void push(lua_State* L, T const& t) { UserdataPtr::push(L, &t); }
 
-    static return_type get(lua_State* L, int index)
+    static return_type get(lua_State* L, int index, bool canBeConst)
     {
-        T* t = Userdata::get<T>(L, index, true);
+        T* t = Userdata::get<T>(L, index, canBeConst);
 
         if (!t)
             luaL_error(L, "nil passed to reference");
@@ -681,6 +1164,12 @@ struct Stack
         StackHelper<T, TypeTraits::isContainer<T>::value>::push(L, value);
     }
 
+    static void push(lua_State* L, T&& value)
+    {
+        using namespace detail;
+        StackHelper<T, TypeTraits::isContainer<T>::value>::push(L, std::move(value));
+    }
+
     static ReturnType get(lua_State* L, int index) { return Getter::get(L, index); }
 
     static bool isInstance(lua_State* L, int index)
@@ -689,6 +1178,33 @@ struct Stack
     }
 };
 
+//------------------------------------------------------------------------------
+/**
+  Lua stack conversions for handles to class objects.
+
+  Lifetime is managed by C++. The object of a handle erased from its map can
+  no longer be accessed from Lua, a Lua error is raised instead.
+*/
+template<class T>
+struct Stack<Handle<T>>
+{
+    static void push(lua_State* L, Handle<T> const& handle)
+    {
+        detail::UserdataHandle::push(L, handle);
+    }
+
+    static Handle<T> get(lua_State* L, int index)
+    {
+        return detail::UserdataHandle::get<T>(L, index);
+    }
+
+    static bool isInstance(lua_State* L, int index)
+    {
+        typedef typename detail::TypeTraits::removeConst<T>::Type U;
+        return detail::Userdata::isInstance<U>(L, index);
+    }
+};
+
 namespace detail {
 
 /**
@@ -749,7 +1265,7 @@ struct StackOpSelector<T&, true>
 
     static void push(lua_State* L, T& value) { UserdataPtr::push(L, &value); }
 
-    static ReturnType get(lua_State* L, int index) { return Helper::get(L, index); }
+    static ReturnType get(lua_State* L, int index) { return Helper::get(L, index, false); }
 
     static bool isInstance(lua_State* L, int index) { return Userdata::isInstance<T>(L, index); }
 };
@@ -763,7 +1279,7 @@ struct StackOpSelector<const T&, true>
 
     static void push(lua_State* L, const T& value) { Helper::push(L, value); }
 
-    static ReturnType get(lua_State* L, int index) { return Helper::get(L, index); }
+    static ReturnType get(lua_State* L, int index) { return Helper::get(L, index, true); }
 
     static bool isInstance(lua_State* L, int index) { return Userdata::isInstance<T>(L, index); }
 };
@@ -4,6 +4,7 @@
 
 #include "TestBase.h"
 
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <map>
@@ -137,6 +138,44 @@ TEST_F(ClassTests, IsInstance)
     ASSERT_TRUE(luabridge::isInstance<OtherClass>(L, -1));
 }
 
+TEST_F(ClassTests, IsInstanceDeepHierarchy)
+{
+    using Level0 = Class<int, EmptyBase>;
+    using Level1 = Class<float, Level0>;
+    using Level2 = Class<double, Level1>;
+    using Level3 = Class<long, Level2>;
+    using Sibling = Class<double, Level0>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Level0>("Level0")
+        .endClass()
+        .deriveClass<Level1, Level0>("Level1")
+        .endClass()
+        .deriveClass<Level2, Level1>("Level2")
+        .endClass()
+        .deriveClass<Level3, Level2>("Level3")
+        .endClass()
+        .deriveClass<Sibling, Level0>("Sibling")
+        .endClass();
+
+    Level3 object;
+    luabridge::push(L, &object);
+
+    ASSERT_TRUE(luabridge::isInstance<Level0>(L, -1));
+    ASSERT_TRUE(luabridge::isInstance<Level1>(L, -1));
+    ASSERT_TRUE(luabridge::isInstance<Level2>(L, -1));
+    ASSERT_TRUE(luabridge::isInstance<Level3>(L, -1));
+    ASSERT_FALSE(luabridge::isInstance<Sibling>(L, -1));
+
+    Level3 const& constObject = object;
+    luabridge::push(L, &constObject);
+    ASSERT_FALSE(luabridge::isInstance<Level0>(L, -1)); // Const objects are not instances
+    ASSERT_EQ(&object, luabridge::Stack<Level0 const*>::get(L, -1));
+
+    runLua("result = io.stdout");
+    ASSERT_FALSE(result().isInstance<Level0>());
+}
+
 TEST_F(ClassTests, PassingUnregisteredClassToLuaThrows)
 {
     using Unregistered = Class<int, EmptyBase>;
@@ -237,6 +276,20 @@ TEST_F(ClassTests, PassOtherTypeInsteadOfNonConstThrows)
     ASSERT_TRUE(result().isNil());
 }
 
+TEST_F(ClassTests, PassForeignUserdataThrows)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .endClass()
+        .addFunction("processNonConst", &processNonConst<int, EmptyBase>);
+
+    // bad argument #1 to 'processNonConst' (Int expected, got userdata)
+    ASSERT_THROW(runLua("result = processNonConst (io.stdout)"), std::exception);
+    ASSERT_TRUE(result().isNil());
+}
+
 TEST_F(ClassTests, PassRegisteredClassInsteadOfUnregisteredThrows)
 {
     using Int = Class<int, EmptyBase>;
@@ -315,6 +368,174 @@ TEST_F(ClassTests, DeriveFromUnregisteredClassThrows)
     ASSERT_EQ(1, lua_gettop(L));
 }
 
+TEST_F(ClassTests, FlattenInheritance)
+{
+    using Base = Class<int, EmptyBase>;
+    using Middle = Class<float, Base>;
+    using Derived = Class<std::string, Middle>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base")
+        .addFunction("method", &Base::method)
+        .addFunction("constMethod", &Base::constMethod)
+        .addProperty("baseData", &Base::data)
+        .endClass()
+        .deriveClass<Middle, Base>("Middle", luabridge::flattenInheritance)
+        .addProperty("middleData", &Middle::getData, &Middle::setData)
+        .endClass()
+        .deriveClass<Derived, Middle>("Derived", luabridge::flattenInheritance)
+        .addFunction("method", &Derived::method)
+        .endClass();
+
+    Derived derived("abc");
+    derived.Base::data = 1;
+    derived.Middle::data = 2.5f;
+    luabridge::setGlobal(L, &derived, "derived");
+    luabridge::setGlobal(L, static_cast<const Derived*>(&derived), "constDerived");
+
+    runLua("result = derived:method ('xyz')");
+    ASSERT_EQ("xyz", result<std::string>());
+
+    runLua("result = derived:constMethod (5)");
+    ASSERT_EQ(5, result<int>());
+
+    runLua("result = derived.baseData + derived.middleData");
+    ASSERT_EQ(3.5f, result<float>());
+
+    runLua("derived.baseData = 10; derived.middleData = 20");
+    ASSERT_EQ(10, derived.Base::data);
+    ASSERT_EQ(20.f, derived.Middle::data);
+
+    runLua("result = constDerived:constMethod (7)");
+    ASSERT_EQ(7, result<int>());
+
+    runLua("result = constDerived.method");
+    ASSERT_TRUE(result().isNil());
+
+    ASSERT_THROW(runLua("constDerived.baseData = 1"), std::exception);
+    ASSERT_EQ(10, derived.Base::data);
+}
+
+TEST_F(ClassTests, FlattenInheritanceReopenBase)
+{
+    using Base = Class<int, EmptyBase>;
+    using Derived = Class<float, Base>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base")
+        .addFunction("name", std::function<std::string(const Base*)>([](const Base*) {
+                         return "base";
+                     }))
+        .endClass()
+        .deriveClass<Derived, Base>("Derived", luabridge::flattenInheritance)
+        .endClass();
+
+    Derived derived(1.5f);
+    derived.Base::data = 3;
+    luabridge::setGlobal(L, &derived, "derived");
+
+    runLua("result = derived:name ()");
+    ASSERT_EQ("base", result<std::string>());
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base")
+        .addFunction("name", std::function<std::string(const Base*)>([](const Base*) {
+                         return "reopened";
+                     }))
+        .addProperty("data", &Base::data)
+        .endClass();
+
+    runLua("result = derived:name ()");
+    ASSERT_EQ("reopened", result<std::string>());
+
+    runLua("result = derived.data");
+    ASSERT_EQ(3, result<int>());
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Derived>("Derived")
+        .addFunction("name", std::function<std::string(const Derived*)>([](const Derived*) {
+                         return "derived";
+                     }))
+        .addProperty("data", &Derived::data)
+        .endClass()
+        .beginClass<Base>("Base")
+        .endClass();
+
+    runLua("result = derived:name ()");
+    ASSERT_EQ("derived", result<std::string>());
+
+    runLua("result = derived.data");
+    ASSERT_EQ(1.5f, result<float>());
+}
+
+namespace {
+
+bool hasIndexTable(lua_State* L, char const* name)
+{
+    luabridge::getGlobal(L, name).push(); // Stack: object
+    lua_getmetatable(L, -1); // Stack: object, metatable
+    luabridge::rawgetfield(L, -1, "__index"); // Stack: object, metatable, __index
+    bool const isTable = lua_istable(L, -1);
+    lua_pop(L, 3);
+    return isTable;
+}
+
+} // namespace
+
+TEST_F(ClassTests, PlainIndexTable)
+{
+    using Base = Class<int, EmptyBase>;
+    using Derived = Class<float, Base>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base", luabridge::plainIndexTable)
+        .addFunction("method", &Base::method)
+        .addFunction("constMethod", &Base::constMethod)
+        .endClass()
+        .deriveClass<Derived, Base>("Derived", luabridge::plainIndexTable)
+        .addFunction("method", &Derived::method)
+        .endClass();
+
+    Derived derived(1.5f);
+    luabridge::setGlobal(L, &derived, "derived");
+    luabridge::setGlobal(L, static_cast<const Derived*>(&derived), "constDerived");
+
+    ASSERT_TRUE(hasIndexTable(L, "derived"));
+    ASSERT_TRUE(hasIndexTable(L, "constDerived"));
+
+    runLua("result = derived:method (2.5)");
+    ASSERT_EQ(2.5f, result<float>());
+
+    runLua("result = derived:constMethod (3)");
+    ASSERT_EQ(3, result<int>());
+
+    runLua("result = constDerived:constMethod (4)");
+    ASSERT_EQ(4, result<int>());
+
+    runLua("result = constDerived.method");
+    ASSERT_TRUE(result().isNil());
+
+    runLua("result = derived.missing");
+    ASSERT_TRUE(result().isNil());
+
+    runLua("result = derived.__gc");
+    ASSERT_TRUE(result().isNil());
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base")
+        .addProperty("data", &Base::data)
+        .endClass();
+
+    ASSERT_FALSE(hasIndexTable(L, "derived"));
+
+    runLua("derived.data = 5; result = derived.data");
+    ASSERT_EQ(5, result<int>());
+    ASSERT_EQ(5, derived.Base::data);
+
+    runLua("result = derived:method (6)");
+    ASSERT_EQ(6.f, result<float>());
+}
+
 struct ClassFunctions : ClassTests
 {
 };
@@ -505,6 +726,276 @@ TEST_F(ClassFunctions, ConstProxyFunctions)
     ASSERT_EQ(5, result<int>());
 }
 
+TEST_F(ClassFunctions, BoundFunctions)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addFunction<decltype(&Int::method), &Int::method>("method")
+        .addFunction<decltype(&Int::constMethod), &Int::constMethod>("constMethod")
+        .addFunction<decltype(&proxyFunction<int, EmptyBase>), &proxyFunction<int, EmptyBase>>(
+            "proxy")
+        .addFunction<decltype(&proxyConstFunction<int, EmptyBase>),
+                     &proxyConstFunction<int, EmptyBase>>("constProxy")
+        .endClass();
+
+    addHelperFunctions(L);
+
+    runLua("result = debug.getinfo (returnRef ().method).nups");
+    ASSERT_EQ(0, result<int>());
+
+    runLua("result = returnRef ():method (1)");
+    ASSERT_EQ(1, result<int>());
+
+    runLua("result = returnConstRef ().method"); // Don't call, just get
+    ASSERT_TRUE(result().isNil());
+
+    runLua("result = returnConstRef ():constMethod (2)");
+    ASSERT_EQ(2, result<int>());
+
+    runLua("result = returnPtr ():proxy (3)");
+    ASSERT_EQ(3, result<int>());
+    ASSERT_EQ(3, returnRef().data);
+
+    runLua("result = returnConstPtr ().proxy"); // Don't call, just get
+    ASSERT_TRUE(result().isNil());
+
+    runLua("result = returnConstPtr ():constProxy (4)");
+    ASSERT_EQ(4, result<int>());
+
+    runLua("result = returnValue ():method (5)");
+    ASSERT_EQ(5, result<int>());
+
+    ASSERT_THROW(runLua("Int.method (1, 2)"), std::exception);
+}
+
+#ifdef LUABRIDGE_CXX17
+
+TEST_F(ClassFunctions, BoundFunctionsAuto)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addFunction<&Int::method>("method")
+        .addFunction<&Int::constMethod>("constMethod")
+        .addFunction<&proxyFunction<int, EmptyBase>>("proxy")
+        .endClass();
+
+    addHelperFunctions(L);
+
+    runLua("result = returnRef ():method (1)");
+    ASSERT_EQ(1, result<int>());
+
+    runLua("result = returnConstRef ():constMethod (2)");
+    ASSERT_EQ(2, result<int>());
+
+    runLua("result = returnPtr ():proxy (3)");
+    ASSERT_EQ(3, result<int>());
+}
+
+#endif // LUABRIDGE_CXX17
+
+namespace {
+
+template<class T, class Base>
+T proxyAdd(Class<T, Base>* object, Class<T, Base> const* other, T value)
+{
+    return object->data + other->data + value;
+}
+
+} // namespace
+
+TEST_F(ClassFunctions, UncheckedFunctions)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addConstructor<void (*)(int)>()
+        .addFunction("method", &Int::method, luabridge::unchecked)
+        .addFunction("constMethod", &Int::constMethod, luabridge::unchecked)
+        .addFunction("proxy", &proxyFunction<int, EmptyBase>, luabridge::unchecked)
+        .addFunction("add", &proxyAdd<int, EmptyBase>, luabridge::unchecked)
+        .addFunction<decltype(&Int::method), &Int::method>("boundMethod", luabridge::unchecked)
+        .addFunction("checkedMethod", &Int::method, luabridge::checked)
+        .endClass();
+
+    addHelperFunctions(L);
+
+    runLua("result = returnRef ():method (1)");
+    ASSERT_EQ(1, result<int>());
+
+    runLua("result = returnConstRef ().method"); // Don't call, just get
+    ASSERT_TRUE(result().isNil());
+
+    runLua("result = returnConstRef ():constMethod (2)");
+    ASSERT_EQ(2, result<int>());
+
+    runLua("result = returnPtr ():proxy (3)");
+    ASSERT_EQ(3, result<int>());
+
+    runLua("result = Int (4):add (Int (5), 6)");
+    ASSERT_EQ(15, result<int>());
+
+    runLua("result = returnValue ():boundMethod (7)");
+    ASSERT_EQ(7, result<int>());
+
+    ASSERT_THROW(runLua("Int (1):checkedMethod ('a')"), std::exception);
+}
+
+#if !defined(NDEBUG) && LUA_VERSION_NUM >= 503
+TEST_F(ClassFunctions, UncheckedFunctions_NonIntegralArgumentAsserts)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addConstructor<void (*)(int)>()
+        .addFunction("method", &Int::method, luabridge::unchecked)
+        .endClass();
+
+    ASSERT_DEATH(runLua("Int (1):method (1.5)"), "");
+}
+#endif
+
+namespace {
+
+struct NonCopyable
+{
+    NonCopyable() : value(0) {}
+
+    NonCopyable(NonCopyable const&) = delete;
+    NonCopyable& operator=(NonCopyable const&) = delete;
+
+    void add(NonCopyable& other, NonCopyable const& amount) { other.value += amount.value + 1; }
+
+    int value;
+};
+
+void addUnchecked(NonCopyable* object, NonCopyable& other)
+{
+    object->value += other.value;
+}
+
+} // namespace
+
+TEST_F(ClassFunctions, ReferenceArgumentsAreNotCopied)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<NonCopyable>("NonCopyable")
+        .addFunction("add", &NonCopyable::add)
+        .addFunction("addUnchecked", &addUnchecked, luabridge::unchecked)
+        .addData("value", &NonCopyable::value)
+        .endClass();
+
+    NonCopyable a;
+    NonCopyable b;
+    b.value = 10;
+    luabridge::setGlobal(L, &a, "a");
+    luabridge::setGlobal(L, &b, "b");
+
+    runLua("a:add (a, b)");
+    ASSERT_EQ(11, a.value);
+
+    runLua("b:addUnchecked (a)");
+    ASSERT_EQ(21, b.value);
+
+    ASSERT_THROW(runLua("a:add (1, b)"), std::exception);
+    ASSERT_THROW(runLua("a:add (a, nil)"), std::exception);
+}
+
+TEST_F(ClassFunctions, ConstObjectIsNotPassedToReference)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<NonCopyable>("NonCopyable")
+        .addFunction("add", &NonCopyable::add)
+        .addFunction("addUnchecked", &addUnchecked, luabridge::unchecked)
+        .endClass();
+
+    NonCopyable a;
+    NonCopyable const b;
+    luabridge::setGlobal(L, &a, "a");
+    luabridge::setGlobal(L, &b, "b");
+
+    ASSERT_THROW(runLua("a:add (b, a)"), std::exception);
+    ASSERT_EQ(0, b.value);
+
+    runLua("a:add (a, b)");
+    ASSERT_EQ(1, a.value);
+
+    luabridge::push(L, &b);
+    ASSERT_EQ(&b, &luabridge::Stack<NonCopyable const&>::get(L, -1));
+    lua_pop(L, 1);
+}
+
+namespace {
+
+struct CopyCounter
+{
+    CopyCounter() : value(0) {}
+
+    explicit CopyCounter(int value) : value(value) {}
+
+    CopyCounter(CopyCounter const& other) : value(other.value) { ++copies; }
+
+    CopyCounter(CopyCounter&& other) : value(other.value) { ++moves; }
+
+    static CopyCounter make(int value) { return CopyCounter(value); }
+
+    CopyCounter twice() const { return CopyCounter(value * 2); }
+
+    static CopyCounter stackTop(int, lua_State* L) { return CopyCounter(lua_gettop(L)); }
+
+    int value;
+
+    static int copies;
+    static int moves;
+};
+
+int CopyCounter::copies = 0;
+int CopyCounter::moves = 0;
+
+} // namespace
+
+TEST_F(ClassFunctions, ReturnedValuesAreNotCopied)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<CopyCounter>("CopyCounter")
+        .addStaticFunction("make", &CopyCounter::make)
+        .addFunction("twice", &CopyCounter::twice)
+        .addData("value", &CopyCounter::value)
+        .endClass();
+
+    CopyCounter::copies = 0;
+    CopyCounter::moves = 0;
+
+    runLua("result = CopyCounter.make (3):twice ().value");
+    ASSERT_EQ(6, result<int>());
+    ASSERT_EQ(0, CopyCounter::copies);
+
+    CopyCounter counter(5);
+    luabridge::Stack<CopyCounter>::push(L, std::move(counter));
+    ASSERT_EQ(0, CopyCounter::copies);
+    ASSERT_EQ(1, CopyCounter::moves);
+    ASSERT_EQ(5, luabridge::Stack<CopyCounter const&>::get(L, -1).value);
+    lua_pop(L, 1);
+}
+
+TEST_F(ClassFunctions, ReturnedValuesOfFunctionsTakingStateSeeTheirArguments)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<CopyCounter>("CopyCounter")
+        .addStaticFunction("stackTop", &CopyCounter::stackTop)
+        .addData("value", &CopyCounter::value)
+        .endClass();
+
+    // The result is not placed on the stack before the call
+    runLua("result = CopyCounter.stackTop (1).value");
+    ASSERT_EQ(1, result<int>());
+}
+
 TEST_F(ClassFunctions, StdFunctions)
 {
     using Int = Class<int, EmptyBase>;
@@ -686,6 +1177,135 @@ TEST_F(ClassProperties, FieldPointers_ReadOnly)
     ASSERT_EQ(42, result<int>());
 }
 
+TEST_F(ClassProperties, FieldPointers_WrongValueThrows)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addConstructor<void (*)(int)>()
+        .addProperty("data", &Int::data, true)
+        .endClass();
+
+    runLua("result = Int (501)");
+    ASSERT_THROW(runLua("result.data = 'abc'"), std::exception);
+    ASSERT_EQ(501, result()["data"].cast<int>());
+
+    runLua("result = pcall (function () result.data = {} end)");
+    ASSERT_FALSE(result<bool>());
+
+    // The stack is left balanced after a failed setter
+    runLua("local x = Int (1) for i = 1, 10 do pcall (function () x.data = {} end) end "
+           "x.data = 3 result = x.data");
+    ASSERT_EQ(3, result<int>());
+}
+
+namespace {
+
+struct Fields
+{
+    bool b;
+    char c;
+    unsigned char uc;
+    short s;
+    unsigned short us;
+    int i;
+    unsigned int ui;
+    long l;
+    unsigned long ul;
+    long long ll;
+    unsigned long long ull;
+    float f;
+    double d;
+};
+
+} // namespace
+
+TEST_F(ClassProperties, FieldPointers_StandardLayout)
+{
+    static_assert(luabridge::detail::IsOffsetField<Fields, double>::value, "");
+    static_assert(!luabridge::detail::IsOffsetField<Fields, std::string>::value, "");
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Fields>("Fields")
+        .addData("b", &Fields::b)
+        .addData("c", &Fields::c)
+        .addData("uc", &Fields::uc)
+        .addData("s", &Fields::s)
+        .addData("us", &Fields::us)
+        .addData("i", &Fields::i)
+        .addData("ui", &Fields::ui, false)
+        .addData("l", &Fields::l)
+        .addData("ul", &Fields::ul)
+        .addData("ll", &Fields::ll)
+        .addData("ull", &Fields::ull)
+        .addData("f", &Fields::f)
+        .addData("d", &Fields::d)
+        .endClass();
+
+    Fields fields = {true, 'x', 200, -3, 4, -5, 6, -7, 8, -9, 10, 1.5f, 2.5};
+    luabridge::setGlobal(L, &fields, "fields");
+    luabridge::setGlobal(L, static_cast<Fields const*>(&fields), "constFields");
+
+    runLua("result = table.concat ({tostring (fields.b), fields.c, fields.uc, fields.s, "
+           "fields.us, fields.i, fields.ui, fields.l, fields.ul, fields.ll, fields.ull, "
+           "fields.f, fields.d}, ' ')");
+    ASSERT_EQ("true x 200 -3 4 -5 6 -7 8 -9 10 1.5 2.5", result<std::string>());
+
+    runLua("fields.b = false fields.c = 'y' fields.uc = 1 fields.s = 2 fields.us = 3 "
+           "fields.i = 4 fields.l = 5 fields.ul = 6 fields.ll = 7 fields.ull = 8 "
+           "fields.f = 0.25 fields.d = 0.125");
+    ASSERT_FALSE(fields.b);
+    ASSERT_EQ('y', fields.c);
+    ASSERT_EQ(1, fields.uc);
+    ASSERT_EQ(2, fields.s);
+    ASSERT_EQ(3, fields.us);
+    ASSERT_EQ(4, fields.i);
+    ASSERT_EQ(5, fields.l);
+    ASSERT_EQ(6u, fields.ul);
+    ASSERT_EQ(7, fields.ll);
+    ASSERT_EQ(8u, fields.ull);
+    ASSERT_EQ(0.25f, fields.f);
+    ASSERT_EQ(0.125, fields.d);
+
+    ASSERT_THROW(runLua("fields.ui = 1"), std::exception);
+    ASSERT_THROW(runLua("fields.i = 'abc'"), std::exception);
+    ASSERT_EQ(4, fields.i);
+
+    runLua("result = constFields.i");
+    ASSERT_EQ(4, result<int>());
+    ASSERT_THROW(runLua("constFields.i = 1"), std::exception);
+    ASSERT_EQ(4, fields.i);
+}
+
+TEST_F(ClassProperties, FieldPointers_FlattenInheritance)
+{
+    using Base = Class<int, EmptyBase>;
+    using Derived = Class<std::string, Base>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base")
+        .addProperty("data", &Base::data, true)
+        .addProperty("data2", &Base::getData, &Base::setData)
+        .endClass()
+        .deriveClass<Derived, Base>("Derived", luabridge::flattenInheritance)
+        .endClass();
+
+    Derived derived("abc");
+    derived.Base::data = 7;
+    luabridge::setGlobal(L, &derived, "derived");
+
+    runLua("result = derived.data");
+    ASSERT_EQ(7, result<int>());
+
+    runLua("derived.data = 12");
+    ASSERT_EQ(12, derived.Base::data);
+
+    runLua("derived.data2 = 13 result = derived.data2");
+    ASSERT_EQ(13, result<int>());
+    ASSERT_EQ("abc", derived.data);
+}
+
 TEST_F(ClassProperties, MemberFunctions)
 {
     using Int = Class<int, EmptyBase>;
@@ -1145,6 +1765,23 @@ TEST_F(ClassStaticFunctions, Functions)
     ASSERT_EQ(35, result<Int>().data);
 }
 
+TEST_F(ClassStaticFunctions, BoundFunctions)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addConstructor<void (*)(int)>()
+        .addStaticFunction<decltype(&Int::staticFunction), &Int::staticFunction>("static")
+        .endClass();
+
+    runLua("result = Int.static (Int (35))");
+    ASSERT_EQ(35, result<Int>().data);
+
+    runLua("result = debug.getinfo (Int.static).nups");
+    ASSERT_EQ(0, result<int>());
+}
+
 TEST_F(ClassStaticFunctions, Functions_Derived)
 {
     using Base = Class<std::string, EmptyBase>;
@@ -1198,6 +1835,24 @@ TEST_F(ClassStaticFunctions, StdFunctions)
     ASSERT_EQ(35, result<Int>().data);
 }
 
+TEST_F(ClassStaticFunctions, Lambdas)
+{
+    using Int = Class<int, EmptyBase>;
+
+    int offset = 10;
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int")
+        .addStaticFunction("add", [offset](int value) { return value + offset; })
+        .addStaticFunction("twice", [](int value) { return value * 2; })
+        .endClass();
+
+    runLua("result = Int.add (2)");
+    ASSERT_EQ(12, result<int>());
+
+    runLua("result = Int.twice (3)");
+    ASSERT_EQ(6, result<int>());
+}
+
 struct ClassStaticProperties : ClassTests
 {
 };
@@ -1584,6 +2239,20 @@ TEST_F(ClassMetaMethods, __index)
     ASSERT_THROW(runLua("result = t.c"), std::exception); // at ("c") throws
 }
 
+TEST_F(ClassMetaMethods, __indexWithPlainIndexTable)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Table>("Table", luabridge::plainIndexTable)
+        .addFunction("__index", &Table::index)
+        .endClass();
+
+    Table t{{{"a", 1}}};
+    luabridge::setGlobal(L, &t, "t");
+
+    runLua("result = t.a");
+    ASSERT_EQ(1, result<int>());
+}
+
 TEST_F(ClassMetaMethods, __newindex)
 {
     luabridge::getGlobalNamespace(L)
@@ -1693,3 +2362,260 @@ TEST_F(ClassTests, DestructorIsCalledOnce)
     L = nullptr;
     ASSERT_EQ(1, InnerClass::destructorCallCount);
 }
+
+namespace {
+
+struct alignas(32) Aligned
+{
+    Aligned() : value(1.5f) {}
+
+    float value;
+};
+
+struct Vec3
+{
+    float x;
+    float y;
+    float z;
+};
+
+} // namespace
+
+TEST_F(ClassTests, ValueStorageIsAligned)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Aligned>("Aligned")
+        .addConstructor<void (*)()>()
+        .addData("value", &Aligned::value)
+        .endClass();
+
+    runLua("result = {} for i = 1, 16 do result [i] = Aligned () end");
+    for (int i = 1; i <= 16; ++i)
+    {
+        Aligned const* const object = result()[i].cast<Aligned const*>();
+        ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(object) % alignof(Aligned));
+        ASSERT_EQ(1.5f, object->value);
+    }
+}
+
+TEST_F(ClassTests, ValueStorageIsCompact)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3")
+        .addConstructor<void (*)()>()
+        .endClass();
+
+    runLua("result = Vec3 ()");
+    result().push(L);
+#if LUA_VERSION_NUM < 502
+    std::size_t const size = lua_objlen(L, -1);
+#else
+    std::size_t const size = lua_rawlen(L, -1);
+#endif
+    lua_pop(L, 1);
+
+    // The class identity, followed by the object
+    ASSERT_EQ(sizeof(std::uintptr_t) + sizeof(Vec3), size);
+}
+
+TEST_F(ClassTests, IdentityCacheReusesUserdata)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3", luabridge::identityCache)
+        .addData("x", &Vec3::x)
+        .endClass();
+
+    Vec3 object;
+    object.x = 1.5;
+    luabridge::setGlobal(L, &object, "first");
+    luabridge::setGlobal(L, &object, "second");
+
+    runLua("result = rawequal (first, second)");
+    ASSERT_TRUE(result<bool>());
+
+    runLua("local t = {} t [first] = 1 result = t [second]");
+    ASSERT_EQ(1, result<int>());
+
+    luabridge::invalidate(L, &object);
+    ASSERT_THROW(runLua("result = second.x"), std::exception);
+
+    luabridge::setGlobal(L, &object, "third");
+    runLua("result = rawequal (first, third)");
+    ASSERT_FALSE(result<bool>());
+    runLua("result = third.x");
+    ASSERT_EQ(1.5, result<double>());
+}
+
+TEST_F(ClassTests, InvalidateClearsUserdataOfAllClasses)
+{
+    struct Base
+    {
+        int x = 1;
+    };
+
+    struct Derived : Base
+    {
+    };
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Base>("Base", luabridge::identityCache)
+        .addData("x", &Base::x)
+        .endClass()
+        .deriveClass<Derived, Base>("Derived", luabridge::identityCache)
+        .endClass();
+
+    Derived object;
+    luabridge::setGlobal(L, static_cast<Base*>(&object), "base");
+    luabridge::setGlobal(L, &object, "derived");
+    luabridge::setGlobal(L, static_cast<Derived const*>(&object), "constDerived");
+
+    luabridge::invalidate(L, static_cast<Base*>(&object));
+    ASSERT_THROW(runLua("result = base.x"), std::exception);
+    ASSERT_THROW(runLua("result = derived.x"), std::exception);
+    ASSERT_THROW(runLua("result = constDerived.x"), std::exception);
+}
+
+TEST_F(ClassTests, WithoutIdentityCachePushesDistinctUserdata)
+{
+    luabridge::getGlobalNamespace(L).beginClass<Vec3>("Vec3").endClass();
+
+    Vec3 object;
+    luabridge::setGlobal(L, &object, "first");
+    luabridge::setGlobal(L, &object, "second");
+
+    runLua("result = rawequal (first, second)");
+    ASSERT_FALSE(result<bool>());
+}
+
+TEST_F(ClassTests, HandleToErasedObjectThrows)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3")
+        .addData("x", &Vec3::x)
+        .endClass();
+
+    luabridge::HandleMap map;
+    Vec3 object;
+    object.x = 1.5;
+    luabridge::Handle<Vec3> const handle = map.insert(&object);
+    luabridge::setGlobal(L, handle, "v");
+
+    runLua("v.x = v.x + 1 result = v");
+    ASSERT_EQ(2.5, object.x);
+    ASSERT_EQ(&object, result<Vec3*>());
+    ASSERT_TRUE(result().isInstance<Vec3>());
+
+    map.erase(handle);
+    ASSERT_FALSE(handle.isValid());
+    ASSERT_THROW(runLua("result = v.x"), std::exception);
+
+    // The reused slot has a new generation
+    Vec3 other;
+    other.x = 3;
+    luabridge::Handle<Vec3 const> const otherHandle = map.insert(static_cast<Vec3 const*>(&other));
+    ASSERT_EQ(1u, map.size());
+    ASSERT_THROW(runLua("result = v.x"), std::exception);
+
+    luabridge::setGlobal(L, otherHandle, "w");
+    runLua("result = w.x");
+    ASSERT_EQ(3, result<float>());
+    ASSERT_THROW(runLua("w.x = 4"), std::exception);
+}
+
+namespace {
+
+float getX(Vec3 const* v)
+{
+    return v->x;
+}
+
+} // namespace
+
+TEST_F(ClassTests, HandleToErasedObjectThrowsInUncheckedCalls)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3")
+        .addFunction("getX", &getX, luabridge::unchecked)
+        .endClass();
+
+    luabridge::HandleMap map;
+    Vec3 object;
+    object.x = 1.5;
+    luabridge::Handle<Vec3> const handle = map.insert(&object);
+    luabridge::setGlobal(L, handle, "v");
+
+    runLua("result = v:getX ()");
+    ASSERT_EQ(1.5, result<float>());
+
+    map.erase(handle);
+    ASSERT_THROW(runLua("result = v:getX ()"), std::exception);
+}
+
+#ifndef NDEBUG
+TEST_F(ClassTests, InvalidatedPointerAssertsInUncheckedCalls)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3", luabridge::identityCache)
+        .addFunction("getX", &getX, luabridge::unchecked)
+        .endClass();
+
+    Vec3 object;
+    object.x = 1.5;
+    luabridge::setGlobal(L, &object, "v");
+    luabridge::invalidate(L, &object);
+
+    ASSERT_DEATH(runLua("result = v:getX ()"), "");
+}
+#endif
+
+TEST_F(ClassTests, HandleOutlivingItsMapThrows)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3")
+        .addData("x", &Vec3::x)
+        .endClass();
+
+    Vec3 object;
+    object.x = 1.5;
+    luabridge::Handle<Vec3> handle;
+    {
+        luabridge::HandleMap map;
+        handle = map.insert(&object);
+        luabridge::setGlobal(L, handle, "v");
+        runLua("result = v.x");
+        ASSERT_EQ(1.5, result<float>());
+    }
+
+    ASSERT_FALSE(handle.isValid());
+    ASSERT_EQ(nullptr, handle.get());
+    ASSERT_THROW(runLua("result = v.x"), std::exception);
+}
+
+TEST_F(ClassTests, HandleFromLua)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec3>("Vec3")
+        .endClass();
+
+    luabridge::HandleMap map;
+    Vec3 object;
+    luabridge::Handle<Vec3> const handle = map.insert(&object);
+    luabridge::setGlobal(L, handle, "v");
+    luabridge::setGlobal(L, &object, "p");
+
+    runLua("result = v");
+    luabridge::Handle<Vec3> const fromLua = result().cast<luabridge::Handle<Vec3>>();
+    ASSERT_TRUE(fromLua.isValid());
+    ASSERT_EQ(&object, fromLua.get());
+    ASSERT_EQ(&object, result().cast<luabridge::Handle<Vec3 const>>().get());
+
+    map.erase(handle);
+    ASSERT_FALSE(fromLua.isValid());
+    ASSERT_FALSE(result().cast<luabridge::Handle<Vec3>>().isValid());
+
+    runLua("result = nil");
+    ASSERT_FALSE(result().cast<luabridge::Handle<Vec3>>().isValid());
+
+    runLua("result = p");
+    ASSERT_THROW(result().cast<luabridge::Handle<Vec3>>(), std::exception);
+}
@@ -6,6 +6,8 @@
 
 #include "LuaBridge/detail/Iterator.h"
 
+#include <vector>
+
 struct IteratorTests : TestBase
 {
 };
@@ -91,3 +93,88 @@ TEST_F(IteratorTests, SequenceIteration)
 
     ASSERT_EQ(expected, actual);
 }
+
+TEST_F(IteratorTests, StackIteration)
+{
+    runLua("result = {a = 1, b = 2, 3, 4}");
+
+    int const top = lua_gettop(L);
+    result().push(L);
+    luabridge::LuaStackRef const table(L, -1);
+
+    std::map<std::string, int> actual;
+    for (luabridge::StackIterator iterator(table); !iterator.isNil(); ++iterator)
+    {
+        ASSERT_EQ(top + 3, lua_gettop(L));
+        actual.emplace(iterator.key().tostring(), iterator.value().cast<int>());
+    }
+    ASSERT_EQ(top + 1, lua_gettop(L));
+
+    std::map<std::string, int> const expected{{"a", 1}, {"b", 2}, {"1", 3}, {"2", 4}};
+    ASSERT_EQ(expected, actual);
+
+    lua_pop(L, 1);
+}
+
+TEST_F(IteratorTests, TypedIteration)
+{
+    runLua("result = {a = 1, b = 2, 10, 20, 30, [5] = 50}");
+
+    int const top = lua_gettop(L);
+    std::map<std::string, int> actual;
+    for (std::pair<std::string, int> entry : luabridge::pairs<std::string, int>(result()))
+    {
+        ASSERT_EQ(top + 4, lua_gettop(L)); // Table, key, value and key copy
+        actual.emplace(entry);
+    }
+    ASSERT_EQ(top, lua_gettop(L));
+
+    std::map<std::string, int> const expected{
+        {"a", 1}, {"b", 2}, {"1", 10}, {"2", 20}, {"3", 30}, {"5", 50}};
+    ASSERT_EQ(expected, actual);
+
+    std::vector<std::pair<int, int>> values;
+    for (std::pair<int, int> entry : luabridge::ipairs<int>(result()))
+    {
+        ASSERT_EQ(top + 2, lua_gettop(L));
+        values.push_back(entry);
+    }
+    ASSERT_EQ(top, lua_gettop(L));
+
+    std::vector<std::pair<int, int>> const expectedValues{{1, 10}, {2, 20}, {3, 30}};
+    ASSERT_EQ(expectedValues, values);
+
+    result().push(L);
+    luabridge::LuaStackRef const table(L, -1);
+    int sum = 0;
+    for (std::pair<int, int> entry : luabridge::ipairs<int>(table))
+    {
+        sum += entry.second;
+    }
+    ASSERT_EQ(60, sum);
+    ASSERT_EQ(top + 1, lua_gettop(L));
+    lua_pop(L, 1);
+
+    runLua("result = {}");
+    for (std::pair<int, int> entry : luabridge::ipairs<int>(result()))
+    {
+        FAIL() << entry.first;
+    }
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(IteratorTests, TypedIterationConvertingNumberKeys)
+{
+    runLua("result = {10, 20, 30, x = 1}");
+
+    int const top = lua_gettop(L);
+    std::map<std::string, int> actual;
+    for (std::pair<char const*, int> entry : luabridge::pairs<char const*, int>(result()))
+    {
+        actual.emplace(entry.first, entry.second);
+    }
+    ASSERT_EQ(top, lua_gettop(L));
+
+    std::map<std::string, int> const expected{{"1", 10}, {"2", 20}, {"3", 30}, {"x", 1}};
+    ASSERT_EQ(expected, actual);
+}
@@ -8,6 +8,8 @@
 #include "LuaBridge/detail/dump.h"
 
 #include <sstream>
+#include <tuple>
+#include <vector>
 
 struct LuaRefTests : TestBase
 {
@@ -364,3 +366,258 @@ TEST_F(LuaRefTests, Print)
         ASSERT_EQ("\"abc\"", stream.str());
     }
 }
+
+namespace {
+
+int sumPoint(luabridge::LuaStackRef point)
+{
+    if (!point.isTable())
+    {
+        return point.cast<int>();
+    }
+    return point["x"].cast<int>() + point["y"].cast<int>() + point.length();
+}
+
+} // namespace
+
+TEST_F(LuaRefTests, StackRef)
+{
+    luabridge::getGlobalNamespace(L).addFunction("sumPoint", &sumPoint);
+
+    runLua("result = sumPoint ({x = 1, y = 2, 10, 20})");
+    ASSERT_EQ(5, result<int>());
+
+    runLua("result = sumPoint (7)");
+    ASSERT_EQ(7, result<int>());
+
+    int const top = lua_gettop(L);
+    runLua("result = {name = 'abc', inner = {value = 3}}");
+    result().push(L);
+    luabridge::LuaStackRef const table(L, -1);
+    ASSERT_TRUE(table.isTable());
+    ASSERT_TRUE(table["name"].isInstance<std::string>());
+    ASSERT_EQ("abc", table["name"].cast<std::string>());
+    ASSERT_TRUE(table["missing"].isNil());
+    ASSERT_EQ(3, table["inner"]["value"].cast<int>());
+    ASSERT_TRUE(table["inner"]["missing"].isNil());
+    ASSERT_EQ(3, table["inner"].toLuaRef()["value"].cast<int>());
+
+    // Use up the free registry references so that a new one grows the registry
+    std::vector<int> refs;
+    for (;;)
+    {
+        int const length = luabridge::get_rawlength(L, LUA_REGISTRYINDEX);
+        lua_pushboolean(L, 1);
+        refs.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+        if (refs.back() > length)
+        {
+            break;
+        }
+    }
+    int const length = luabridge::get_rawlength(L, LUA_REGISTRYINDEX);
+    ASSERT_EQ(3, table["inner"]["value"].cast<int>());
+    ASSERT_EQ(length, luabridge::get_rawlength(L, LUA_REGISTRYINDEX));
+    for (int ref : refs)
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    }
+
+    luabridge::LuaRef const ref = table.toLuaRef();
+    lua_pop(L, 1);
+    ASSERT_EQ(top, lua_gettop(L));
+    ASSERT_EQ("abc", ref["name"].cast<std::string>());
+}
+
+TEST_F(LuaRefTests, Move)
+{
+    runLua("result = {a = 1, b = 2}");
+
+    luabridge::LuaRef source = result();
+    luabridge::LuaRef moved(std::move(source));
+    ASSERT_TRUE(source.isNil());
+    ASSERT_EQ(1, moved["a"].cast<int>());
+
+    luabridge::LuaRef assigned(L);
+    assigned = std::move(moved);
+    ASSERT_TRUE(moved.isNil());
+    ASSERT_EQ(2, assigned["b"].cast<int>());
+
+    std::vector<luabridge::LuaRef> refs;
+    for (int i = 0; i < 16; ++i)
+    {
+        refs.push_back(luabridge::LuaRef(L, i));
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(i, refs[i].cast<int>());
+    }
+
+    // Assigning a table item copies the value, it does not rebind the item
+    assigned["a"] = assigned["b"];
+    ASSERT_EQ(2, result()["a"].cast<int>());
+    ASSERT_EQ(2, result()["b"].cast<int>());
+}
+
+TEST_F(LuaRefTests, Path)
+{
+    runLua("config = {player = {speed = 1.5, name = 'abc'}}");
+
+    int const top = lua_gettop(L);
+    luabridge::LuaPath const speed(L, {"config", "player", "speed"});
+    ASSERT_EQ(1.5, speed.get<double>());
+    ASSERT_EQ(1.5, speed.rawget<double>());
+
+    speed.set(2.5);
+    runLua("result = config.player.speed");
+    ASSERT_EQ(2.5, result<double>());
+
+    speed.rawset(3);
+    ASSERT_EQ(3, speed.get<int>());
+
+    luabridge::LuaPath const name(L, {"player", "name"});
+    luabridge::LuaRef const config = luabridge::getGlobal(L, "config");
+    ASSERT_EQ("abc", name.get<std::string>(config));
+    name.set(config, std::string("def"));
+    ASSERT_EQ("def", config["player"]["name"].cast<std::string>());
+
+    config.push();
+    luabridge::LuaStackRef const root(L, -1);
+    ASSERT_EQ("def", name.get<std::string>(root));
+    lua_pop(L, 1);
+
+    luabridge::LuaPath const missing(L, {"config", "enemy", "speed"});
+    ASSERT_TRUE(missing.get<luabridge::LuaRef>().isNil());
+    ASSERT_TRUE(missing.rawget<luabridge::LuaRef>().isNil());
+
+    missing.push();
+    ASSERT_TRUE(lua_isnil(L, -1));
+    lua_pop(L, 1);
+    ASSERT_EQ(top, lua_gettop(L));
+
+    runLua("proxy = setmetatable ({}, {__index = config})");
+    luabridge::LuaPath const proxied(L, {"proxy", "player", "speed"});
+    ASSERT_EQ(3, proxied.get<int>());
+    ASSERT_TRUE(proxied.rawget<luabridge::LuaRef>().isNil());
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaRefTests, Value)
+{
+    luabridge::LuaValue const nil(L);
+    ASSERT_TRUE(nil.isNil());
+    ASSERT_TRUE(nil.isInline());
+
+    luabridge::LuaValue const integer(L, 42);
+    ASSERT_TRUE(integer.isInline());
+    ASSERT_TRUE(integer.isNumber());
+    ASSERT_EQ(42, integer.cast<int>());
+
+    luabridge::LuaValue const number(L, 1.5);
+    ASSERT_TRUE(number.isInline());
+    ASSERT_EQ(1.5, number.cast<double>());
+
+    luabridge::LuaValue const boolean(L, true);
+    ASSERT_TRUE(boolean.isInline());
+    ASSERT_TRUE(boolean.cast<bool>());
+
+    int object = 0;
+    lua_pushlightuserdata(L, &object);
+    luabridge::LuaValue const pointer = luabridge::LuaValue::fromStack(L, -1);
+    lua_pop(L, 1);
+    ASSERT_TRUE(pointer.isInline());
+    ASSERT_TRUE(pointer.isLightUserdata());
+
+    luabridge::LuaValue const string(L, "abc");
+    ASSERT_FALSE(string.isInline());
+    ASSERT_EQ("abc", string.cast<std::string>());
+
+    runLua("result = {x = 3}");
+    luabridge::LuaValue table = result();
+    ASSERT_FALSE(table.isInline());
+    ASSERT_EQ(3, table.toLuaRef()["x"].cast<int>());
+
+    luabridge::LuaValue copy = table;
+    ASSERT_TRUE(copy.rawequal(table));
+    luabridge::LuaValue moved = std::move(copy);
+    ASSERT_TRUE(copy.isNil());
+    ASSERT_TRUE(moved.rawequal(table));
+    moved = integer;
+    ASSERT_EQ(42, moved.cast<int>());
+    table = result()["x"];
+    ASSERT_TRUE(table.isInline());
+    ASSERT_EQ(3, table.cast<int>());
+
+    luabridge::setGlobal(L, integer, "result");
+    ASSERT_EQ(42, result<int>());
+    ASSERT_EQ(42, result<luabridge::LuaValue>().cast<int>());
+
+#if LUA_VERSION_NUM >= 503
+    integer.push(L);
+    ASSERT_TRUE(lua_isinteger(L, -1));
+    number.push(L);
+    ASSERT_FALSE(lua_isinteger(L, -1));
+    lua_pop(L, 2);
+#endif
+}
+
+TEST_F(LuaRefTests, Function)
+{
+    runLua("function add (x, y) return x + y end "
+           "function divmod (x, y) return math.floor (x / y), x % y, 'done' end "
+           "function store (x) result = x end "
+           "function fail (message) error (message, 0) end");
+
+    int const top = lua_gettop(L);
+    luabridge::LuaFunction<int(int, int)> const add = luabridge::getGlobal(L, "add");
+    ASSERT_EQ(3, add(1, 2));
+    ASSERT_EQ(7, add.call(3, 4));
+
+    luabridge::LuaFunction<std::tuple<int, int, std::string>(int, int)> const divmod =
+        luabridge::getGlobal(L, "divmod");
+    ASSERT_EQ(std::make_tuple(3, 2, std::string("done")), divmod(17, 5));
+
+    luabridge::LuaFunction<void(std::string const&)> const store =
+        luabridge::getGlobal(L, "store");
+    store("abc");
+    ASSERT_EQ("abc", result<std::string>());
+    ASSERT_EQ(top, lua_gettop(L));
+
+    luabridge::LuaFunction<void(char const*)> const fail = luabridge::getGlobal(L, "fail");
+    ASSERT_THROW(fail("message"), luabridge::LuaException);
+    ASSERT_EQ(top, lua_gettop(L));
+
+    runLua("function handler (message) return 'handled: ' .. message end");
+    luabridge::LuaFunction<void(char const*)> const handled(luabridge::getGlobal(L, "fail"),
+                                                              luabridge::getGlobal(L, "handler"));
+    try
+    {
+        handled("message");
+        FAIL();
+    }
+    catch (luabridge::LuaException const& e)
+    {
+        ASSERT_EQ(std::string("handled: message"), e.what());
+    }
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaRefTests, FunctionTakingReference)
+{
+    struct Counter
+    {
+        int value = 0;
+    };
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counter>("Counter")
+        .addData("value", &Counter::value)
+        .endClass();
+
+    runLua("function increment (counter) counter.value = counter.value + 1 end");
+
+    Counter counter;
+    luabridge::LuaFunction<void(Counter&)> const increment = luabridge::getGlobal(L, "increment");
+    increment(counter);
+    increment.call(counter);
+    ASSERT_EQ(2, counter.value);
+}
@@ -0,0 +1,131 @@
+// https://github.com/vinniefalco/LuaBridge
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include "LuaBridge/Memory.h"
+
+#include <memory>
+
+namespace {
+
+struct Base
+{
+    explicit Base(int value) : value(value) { ++instances; }
+
+    virtual ~Base() { --instances; }
+
+    int value;
+
+    static int instances;
+};
+
+int Base::instances = 0;
+
+struct Derived : Base
+{
+    explicit Derived(int value) : Base(value) {}
+};
+
+std::shared_ptr<Derived> makeShared(int value)
+{
+    return std::make_shared<Derived>(value);
+}
+
+std::unique_ptr<Derived> makeUnique(int value)
+{
+    return std::unique_ptr<Derived>(new Derived(value));
+}
+
+int getValue(std::shared_ptr<Base const> const& p)
+{
+    return p->value;
+}
+
+} // namespace
+
+struct MemoryTests : TestBase
+{
+    void SetUp() override
+    {
+        TestBase::SetUp();
+
+        Base::instances = 0;
+
+        luabridge::getGlobalNamespace(L)
+            .beginClass<Base>("Base")
+            .addConstructor<void (*)(int)>()
+            .addData("value", &Base::value)
+            .endClass()
+            .deriveClass<Derived, Base>("Derived")
+            .endClass()
+            .addFunction("makeShared", &makeShared)
+            .addFunction("makeUnique", &makeUnique)
+            .addFunction("getValue", &getValue);
+    }
+
+    void collectGarbage() { lua_gc(L, LUA_GCCOLLECT, 0); }
+};
+
+TEST_F(MemoryTests, SharedPtrSharesTheControlBlock)
+{
+    std::shared_ptr<Derived> const p = std::make_shared<Derived>(1);
+    luabridge::setGlobal(L, p, "object");
+    ASSERT_EQ(2, p.use_count());
+
+    runLua("result = object");
+    std::shared_ptr<Base> const base = result<std::shared_ptr<Base>>();
+    ASSERT_EQ(p.get(), base.get());
+    ASSERT_EQ(3, p.use_count());
+
+    runLua("object = nil result = nil");
+    collectGarbage();
+    ASSERT_EQ(2, p.use_count());
+}
+
+TEST_F(MemoryTests, SharedPtrIsReleasedByLua)
+{
+    runLua("result = makeShared (2) result = getValue (result) + result.value");
+    ASSERT_EQ(4, result<int>());
+    ASSERT_EQ(1, Base::instances);
+
+    runLua("result = nil");
+    collectGarbage();
+    ASSERT_EQ(0, Base::instances);
+}
+
+TEST_F(MemoryTests, SharedPtrToConstObject)
+{
+    luabridge::setGlobal(L, std::make_shared<Base const>(3), "object");
+
+    runLua("result = getValue (object)");
+    ASSERT_EQ(3, result<int>());
+
+    ASSERT_THROW(runLua("object.value = 4"), std::exception);
+    runLua("result = object");
+    ASSERT_THROW(result<std::shared_ptr<Base>>(), std::exception);
+}
+
+TEST_F(MemoryTests, ObjectNotOwnedBySharedPtr)
+{
+    ASSERT_THROW(runLua("result = getValue (Base (5))"), std::exception);
+
+    Base object(6);
+    luabridge::setGlobal(L, &object, "object");
+    ASSERT_THROW(runLua("result = getValue (object)"), std::exception);
+}
+
+TEST_F(MemoryTests, UniquePtrTransfersOwnership)
+{
+    runLua("result = makeUnique (7)");
+    ASSERT_EQ(1, Base::instances);
+    ASSERT_EQ(7, result<Derived*>()->value);
+
+    std::shared_ptr<Base> p = result<std::shared_ptr<Base>>();
+    runLua("result = nil");
+    collectGarbage();
+    ASSERT_EQ(1, Base::instances);
+
+    p.reset();
+    ASSERT_EQ(0, Base::instances);
+}
@@ -5,6 +5,9 @@
 #include "TestBase.h"
 
 #include <functional>
+#include <sstream>
+#include <string>
+#include <tuple>
 
 struct NamespaceTests : TestBase
 {
@@ -294,6 +297,53 @@ TEST_F(NamespaceTests, Functions)
     ASSERT_EQ(3.14, result<double>());
 }
 
+TEST_F(NamespaceTests, BoundFunctions)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFunction<decltype(&Function<double>), &Function<double>>("Function");
+
+    runLua("result = Function (3.14)");
+    ASSERT_TRUE(result().isNumber());
+    ASSERT_EQ(3.14, result<double>());
+
+    runLua("result = debug.getinfo (Function).nups");
+    ASSERT_EQ(0, result<int>());
+
+#ifdef LUABRIDGE_CXX17
+    luabridge::getGlobalNamespace(L).addFunction<&Function<int>>("IntFunction");
+
+    runLua("result = IntFunction (12)");
+    ASSERT_EQ(12, result<int>());
+#endif // LUABRIDGE_CXX17
+}
+
+namespace {
+
+std::string UncheckedFunction(int i, double d, bool b, std::string const& s, unsigned char c)
+{
+    std::ostringstream stream;
+    stream << i << ' ' << d << ' ' << b << ' ' << s << ' ' << int(c);
+    return stream.str();
+}
+
+} // namespace
+
+TEST_F(NamespaceTests, UncheckedFunctions)
+{
+    luabridge::getGlobalNamespace(L).addFunction(
+        "Function", &UncheckedFunction, luabridge::unchecked);
+
+    runLua("result = Function (-1, 2.5, true, 'text', 200)");
+    ASSERT_EQ("-1 2.5 1 text 200", result<std::string>());
+
+    luabridge::getGlobalNamespace(L)
+        .addFunction<decltype(&Function<int>), &Function<int>>("BoundFunction",
+                                                                luabridge::unchecked);
+
+    runLua("result = BoundFunction (12)");
+    ASSERT_EQ(12, result<int>());
+}
+
 TEST_F(NamespaceTests, StdFunctions)
 {
     luabridge::getGlobalNamespace(L).addFunction("Function",
@@ -304,6 +354,120 @@ TEST_F(NamespaceTests, StdFunctions)
     ASSERT_EQ(12, result<int>());
 }
 
+namespace {
+
+std::tuple<int, std::string, bool> TupleFunction(int value)
+{
+    return std::make_tuple(value + 1, std::to_string(value), value > 0);
+}
+
+struct TuplePoint
+{
+    std::tuple<int, int> coordinates() const { return std::make_tuple(x, y); }
+
+    std::tuple<TuplePoint&, int> withSum() { return std::tuple<TuplePoint&, int>(*this, x + y); }
+
+    int x;
+    int y;
+};
+
+} // namespace
+
+TEST_F(NamespaceTests, TupleResults)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFunction("Tuple", &TupleFunction)
+        .addFunction("Empty", [] { return std::tuple<>(); })
+        .addFunction("DivMod",
+                     [](int x, int y) { return std::make_tuple(x / y, x % y); });
+
+    runLua("local a, b, c = Tuple (5) result = {a, b, c}");
+    ASSERT_EQ(6, result()[1].cast<int>());
+    ASSERT_EQ("5", result()[2].cast<std::string>());
+    ASSERT_TRUE(result()[3].cast<bool>());
+
+    runLua("result = select ('#', Empty ())");
+    ASSERT_EQ(0, result<int>());
+
+    runLua("result = select ('#', DivMod (17, 5))");
+    ASSERT_EQ(2, result<int>());
+
+    luabridge::LuaRef const divMod = luabridge::getGlobal(L, "DivMod");
+    ASSERT_EQ(std::make_tuple(3, 2), (divMod.callAs<std::tuple<int, int>>(17, 5)));
+    ASSERT_EQ(3, divMod.callAs<int>(17, 5));
+    divMod.callAs<void>(17, 5);
+
+    TuplePoint point = {1, 2};
+    luabridge::getGlobalNamespace(L)
+        .beginClass<TuplePoint>("TuplePoint")
+        .addFunction("coordinates", &TuplePoint::coordinates)
+        .addFunction("withSum", &TuplePoint::withSum)
+        .addData("x", &TuplePoint::x)
+        .endClass();
+    luabridge::setGlobal(L, &point, "point");
+
+    runLua("local x, y = point:coordinates () result = x * 10 + y");
+    ASSERT_EQ(12, result<int>());
+
+    runLua("local p, sum = point:withSum () p.x = sum result = p.x");
+    ASSERT_EQ(3, result<int>());
+    ASSERT_EQ(3, point.x);
+}
+
+TEST_F(NamespaceTests, Lambdas)
+{
+    int offset = 10;
+    int calls = 0;
+    luabridge::getGlobalNamespace(L)
+        .addFunction("add", [offset](int value) { return value + offset; })
+        .addFunction("count", [&calls]() mutable { return ++calls; })
+        .addFunction("raw", [](lua_State* L) {
+            lua_pushinteger(L, 1);
+            lua_pushinteger(L, 2);
+            return 2;
+        });
+
+    runLua("result = add (2)");
+    ASSERT_EQ(12, result<int>());
+
+    runLua("count () result = count ()");
+    ASSERT_EQ(2, result<int>());
+    ASSERT_EQ(2, calls);
+
+    runLua("local a, b = raw () result = a + b");
+    ASSERT_EQ(3, result<int>());
+}
+
+TEST_F(NamespaceTests, StdFunctionCallbacks)
+{
+    std::function<int(int)> handler;
+    luabridge::getGlobalNamespace(L)
+        .addFunction("setHandler", [&handler](std::function<int(int)> f) { handler = f; })
+        .addFunction("getHandler", [&handler]() { return handler; })
+        .addFunction("apply", [](std::function<int(int)> f, int value) { return f(value); });
+
+    runLua("function twice (x) return x * 2 end setHandler (twice)");
+    ASSERT_TRUE(static_cast<bool>(handler));
+    ASSERT_EQ(10, handler(5));
+
+    std::function<int(int)> const copy = handler;
+    ASSERT_EQ(14, copy(7));
+
+    runLua("result = getHandler () == twice");
+    ASSERT_TRUE(result<bool>());
+
+    luabridge::setGlobal(L, std::function<int(int)>([](int x) { return x + 1; }), "increment");
+    runLua("result = apply (increment, 1) + apply (twice, 3)");
+    ASSERT_EQ(8, result<int>());
+
+    runLua("setHandler (nil) result = getHandler ()");
+    ASSERT_FALSE(static_cast<bool>(handler));
+    ASSERT_TRUE(result().isNil());
+
+    runLua("setHandler (function (x) error ('failed', 0) end)");
+    ASSERT_THROW(handler(1), luabridge::LuaException);
+}
+
 #ifdef _M_IX86 // Windows 32bit only
 
 namespace {
@@ -6,11 +6,15 @@
 
 #include "TestBase.h"
 
+#include "LuaBridge/Pair.h"
+#include "LuaBridge/Vector.h"
+
 #include <cstdio>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <tuple>
 #include <vector>
 
 using namespace std;
@@ -64,6 +68,45 @@ struct A
     void setprop(int v) { prop = v; }
 };
 
+struct B : A
+{
+};
+
+struct C : B
+{
+};
+
+struct D : C
+{
+};
+
+struct E : D
+{
+};
+
+struct Buffer
+{
+    Buffer() : data(256) {}
+
+    Buffer scaled(double factor) const
+    {
+        Buffer result(*this);
+        for (std::size_t i = 0; i < result.data.size(); ++i)
+        {
+            result.data[i] *= factor;
+        }
+        return result;
+    }
+
+    std::vector<double> data;
+};
+
+struct Point
+{
+    double x;
+    double y;
+};
+
 //------------------------------------------------------------------------------
 
 void addToState(lua_State* L)
@@ -80,19 +123,17 @@ void addToState(lua_State* L)
         .endClass();
 }
 
-void runTests(lua_State* L)
+void timeChunk(lua_State* L, char const* chunk)
 {
     cout.precision(4);
 
     int result;
 
-    luaL_dostring(L, "a = A()");
-
     int const trials = 5;
 
     for (int trial = 0; trial < trials; ++trial)
     {
-        result = luaL_loadstring(L, "a:mf1 ()");
+        result = luaL_loadstring(L, chunk);
         if (result != 0)
             lua_error(L);
 
@@ -110,9 +151,17 @@ void runTests(lua_State* L)
         double const seconds = sw.getElapsedSeconds();
 
         cout << "Elapsed time: " << seconds << endl;
+
+        lua_pop(L, 1);
     }
 }
 
+void runTests(lua_State* L)
+{
+    luaL_dostring(L, "a = A()");
+    timeChunk(L, "a:mf1 ()");
+}
+
 void runPerformanceTests()
 {
     lua_State* L = luaL_newstate();
@@ -124,6 +173,54 @@ void runPerformanceTests()
     lua_close(L);
 }
 
+template<class T>
+void timeVectorConversion(lua_State* L, char const* typeName, T (*makeValue)(int))
+{
+    cout.precision(4);
+
+    for (int size = 10; size <= 1000000; size *= 10)
+    {
+        std::vector<T> vector;
+        vector.reserve(size);
+        for (int i = 0; i < size; ++i)
+        {
+            vector.push_back(makeValue(i));
+        }
+
+        int const repeats = 1000000 / size;
+
+        Stopwatch sw;
+        for (int i = 0; i < repeats; ++i)
+        {
+            Stack<std::vector<T>>::push(L, vector);
+            std::vector<T> const copy = Stack<std::vector<T>>::get(L, -1);
+            lua_pop(L, 1);
+        }
+
+        cout << typeName << " x " << size << ": " << sw.getElapsedSeconds() << endl;
+    }
+}
+
+int makeInt(int i)
+{
+    return i;
+}
+
+double makeDouble(int i)
+{
+    return i * 0.5;
+}
+
+std::string makeString(int i)
+{
+    return std::to_string(i);
+}
+
+A makeA(int)
+{
+    return A();
+}
+
 struct PerformanceTests : TestBase
 {
 };
@@ -133,3 +230,295 @@ TEST_F(PerformanceTests, AllTests)
     addToState(L);
     runTests(L);
 }
+
+TEST_F(PerformanceTests, PlainIndexTable)
+{
+    getGlobalNamespace(L)
+        .beginClass<A>("A", plainIndexTable)
+        .addConstructor<void (*)(void)>()
+        .addFunction("mf1", &A::mf1)
+        .endClass();
+
+    luaL_dostring(L, "a = A()");
+    timeChunk(L, "a:mf1 ()");
+}
+
+TEST_F(PerformanceTests, DeepHierarchy)
+{
+    getGlobalNamespace(L)
+        .beginClass<A>("A")
+        .addFunction("mf1", &A::mf1)
+        .endClass()
+        .deriveClass<B, A>("B", flattenInheritance)
+        .endClass()
+        .deriveClass<C, B>("C", flattenInheritance)
+        .endClass()
+        .deriveClass<D, C>("D", flattenInheritance)
+        .endClass()
+        .deriveClass<E, D>("E", flattenInheritance)
+        .addConstructor<void (*)(void)>()
+        .endClass();
+
+    luaL_dostring(L, "e = E()");
+    timeChunk(L, "e:mf1 ()");
+}
+
+TEST_F(PerformanceTests, BoundFunction)
+{
+    getGlobalNamespace(L)
+        .beginClass<A>("A")
+        .addConstructor<void (*)(void)>()
+        .addFunction<decltype(&A::mf1), &A::mf1>("mf1")
+        .endClass();
+
+    luaL_dostring(L, "a = A()");
+    timeChunk(L, "a:mf1 ()");
+}
+
+TEST_F(PerformanceTests, UncheckedCalls)
+{
+    getGlobalNamespace(L)
+        .beginClass<A>("A")
+        .addConstructor<void (*)(void)>()
+        .addFunction("mf2", &A::mf2)
+        .addFunction("uncheckedMf2", &A::mf2, unchecked)
+        .endClass();
+
+    luaL_dostring(L, "a = A()");
+    timeChunk(L, "a:mf2 (a)");
+    timeChunk(L, "a:uncheckedMf2 (a)");
+}
+
+TEST_F(PerformanceTests, Properties)
+{
+    addToState(L);
+
+    luaL_dostring(L, "a = A()");
+    timeChunk(L, "a.data = a.data + 1");
+    timeChunk(L, "a.prop = a.prop + 1");
+}
+
+TEST_F(PerformanceTests, StandardLayoutFields)
+{
+    getGlobalNamespace(L)
+        .beginClass<Point>("Point")
+        .addConstructor<void (*)(void)>()
+        .addData("x", &Point::x)
+        .addData("y", &Point::y)
+        .endClass();
+
+    luaL_dostring(L, "p = Point() p.x = 0 p.y = 1");
+    timeChunk(L, "p.x = p.x + p.y");
+}
+
+TEST_F(PerformanceTests, ReturnByValue)
+{
+    getGlobalNamespace(L)
+        .beginClass<Buffer>("Buffer")
+        .addConstructor<void (*)(void)>()
+        .addFunction("scaled", &Buffer::scaled)
+        .endClass();
+
+    luaL_dostring(L, "b = Buffer()");
+    timeChunk(L, "b:scaled (2)");
+}
+
+TEST_F(PerformanceTests, IdentityCache)
+{
+    getGlobalNamespace(L)
+        .beginClass<A>("A", identityCache)
+        .addFunction("self", std::function<A*(A*)>([](A* a) { return a; }))
+        .endClass();
+
+    A a;
+    setGlobal(L, &a, "a");
+    luaL_dostring(L, "t = {}");
+    timeChunk(L, "t [a:self ()] = true");
+}
+
+TEST_F(PerformanceTests, Handles)
+{
+    addToState(L);
+
+    A a;
+    HandleMap map;
+    setGlobal(L, &a, "a");
+    setGlobal(L, map.insert(&a), "h");
+    timeChunk(L, "a:mf1 ()");
+    timeChunk(L, "h:mf1 ()");
+}
+
+TEST_F(PerformanceTests, StackRefArguments)
+{
+    getGlobalNamespace(L)
+        .addFunction("refX",
+                     std::function<int(LuaRef)>([](LuaRef t) { return t["x"].cast<int>(); }))
+        .addFunction("stackRefX", std::function<int(LuaStackRef)>([](LuaStackRef t) {
+                         return t["x"].cast<int>();
+                     }));
+
+    luaL_dostring(L, "t = {x = 1}");
+    timeChunk(L, "refX (t)");
+    timeChunk(L, "stackRefX (t)");
+}
+
+TEST_F(PerformanceTests, PathLookup)
+{
+    luaL_dostring(L, "config = {player = {speed = 1}}");
+
+    LuaPath const speed(L, {"config", "player", "speed"});
+    getGlobalNamespace(L)
+        .addFunction("refSpeed", std::function<int()>([this] {
+                         return getGlobal(L, "config")["player"]["speed"].cast<int>();
+                     }))
+        .addFunction("pathSpeed", std::function<int()>([&speed] { return speed.get<int>(); }));
+
+    timeChunk(L, "refSpeed ()");
+    timeChunk(L, "pathSpeed ()");
+}
+
+TEST_F(PerformanceTests, TypedIteration)
+{
+    luaL_dostring(L, "t = {} for i = 1, 100000 do t [i] = i t ['k' .. i] = i end");
+    LuaRef const table = getGlobal(L, "t");
+
+    cout.precision(4);
+    for (int trial = 0; trial < 5; ++trial)
+    {
+        long long refSum = 0;
+        long long pairsSum = 0;
+        long long ipairsSum = 0;
+
+        Stopwatch sw;
+        for (std::pair<LuaRef, LuaRef> entry : pairs(table))
+        {
+            refSum += entry.second.cast<int>();
+        }
+        double const refSeconds = sw.getElapsedSeconds();
+
+        sw.start();
+        for (std::pair<LuaStackRef, int> entry : pairs<LuaStackRef, int>(table))
+        {
+            pairsSum += entry.second;
+        }
+        double const pairsSeconds = sw.getElapsedSeconds();
+
+        sw.start();
+        for (std::pair<int, int> entry : ipairs<int>(table))
+        {
+            ipairsSum += entry.second;
+        }
+        double const ipairsSeconds = sw.getElapsedSeconds();
+
+        ASSERT_EQ(refSum, pairsSum);
+        ASSERT_EQ(refSum, ipairsSum * 2);
+        cout << "pairs: " << refSeconds << ", typed pairs: " << pairsSeconds
+             << ", typed ipairs: " << ipairsSeconds << endl;
+    }
+}
+
+TEST_F(PerformanceTests, InlineValues)
+{
+    int const count = 100000;
+
+    cout.precision(4);
+    for (int trial = 0; trial < 5; ++trial)
+    {
+        Stopwatch sw;
+        {
+            std::vector<LuaRef> refs;
+            refs.reserve(count);
+            for (int i = 0; i < count; ++i)
+            {
+                refs.push_back(LuaRef(L, i));
+            }
+            for (LuaRef const& ref : refs)
+            {
+                ref.push();
+                lua_pop(L, 1);
+            }
+        }
+        double const refSeconds = sw.getElapsedSeconds();
+
+        sw.start();
+        {
+            std::vector<LuaValue> values;
+            values.reserve(count);
+            for (int i = 0; i < count; ++i)
+            {
+                values.push_back(LuaValue(L, i));
+            }
+            for (LuaValue const& value : values)
+            {
+                value.push();
+                lua_pop(L, 1);
+            }
+        }
+        double const valueSeconds = sw.getElapsedSeconds();
+
+        cout << "LuaRef: " << refSeconds << ", LuaValue: " << valueSeconds << endl;
+    }
+}
+
+TEST_F(PerformanceTests, TypedFunctionCalls)
+{
+    luaL_dostring(L, "function hook (x, y) return x + y end");
+    LuaRef const ref = getGlobal(L, "hook");
+    LuaFunction<int(int, int)> const hook = ref;
+
+    int const count = 1000000;
+
+    cout.precision(4);
+    for (int trial = 0; trial < 5; ++trial)
+    {
+        long long refSum = 0;
+        long long hookSum = 0;
+        long long callSum = 0;
+
+        Stopwatch sw;
+        for (int i = 0; i < count; ++i)
+        {
+            refSum += ref(i, 1).cast<int>();
+        }
+        double const refSeconds = sw.getElapsedSeconds();
+
+        sw.start();
+        for (int i = 0; i < count; ++i)
+        {
+            hookSum += hook(i, 1);
+        }
+        double const hookSeconds = sw.getElapsedSeconds();
+
+        sw.start();
+        for (int i = 0; i < count; ++i)
+        {
+            callSum += hook.call(i, 1);
+        }
+        double const callSeconds = sw.getElapsedSeconds();
+
+        ASSERT_EQ(refSum, hookSum);
+        ASSERT_EQ(refSum, callSum);
+        cout << "LuaRef: " << refSeconds << ", LuaFunction: " << hookSeconds
+             << ", unprotected: " << callSeconds << endl;
+    }
+}
+
+TEST_F(PerformanceTests, TupleResults)
+{
+    getGlobalNamespace(L)
+        .addFunction("pairResult", [](int x) { return std::make_pair(x, x + 1); })
+        .addFunction("tupleResult", [](int x) { return std::make_tuple(x, x + 1); });
+
+    timeChunk(L, "local p = pairResult (1) local a, b = p [1], p [2]");
+    timeChunk(L, "local a, b = tupleResult (1)");
+}
+
+TEST_F(PerformanceTests, VectorConversions)
+{
+    addToState(L);
+
+    timeVectorConversion(L, "int", &makeInt);
+    timeVectorConversion(L, "double", &makeDouble);
+    timeVectorConversion(L, "std::string", &makeString);
+    timeVectorConversion(L, "userdata", &makeA);
+}
@@ -6,7 +6,11 @@
 
 #include "LuaBridge/RefCountedObject.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 struct RefCountedObjectTests : TestBase
 {
@@ -310,3 +314,160 @@ TEST_F(RefCountedObjectTests, LastReferenceInCpp)
     object = nullptr;
     ASSERT_EQ(true, deleted);
 }
+
+namespace {
+
+class AtomicRefCounted : public luabridge::AtomicRefCountedObject
+{
+public:
+    explicit AtomicRefCounted(std::atomic<int>& deletions) : m_deletions(deletions) {}
+
+    ~AtomicRefCounted() { ++m_deletions; }
+
+private:
+    std::atomic<int>& m_deletions;
+};
+
+class Pooled : public luabridge::RefCountedObjectType<int, luabridge::PooledDelete>
+{
+public:
+    explicit Pooled(bool& deleted) : m_deleted(deleted) { m_deleted = false; }
+
+    ~Pooled() { m_deleted = true; }
+
+    bool isDeleted() const { return m_deleted; }
+
+private:
+    bool& m_deleted;
+};
+
+class PooledShared : public luabridge::RefCountedObjectType<std::atomic<int>, luabridge::PooledDelete>
+{
+public:
+    char payload[200];
+};
+
+class PooledValue : public luabridge::RefCountedObjectType<int, luabridge::PooledDelete>
+{
+public:
+    explicit PooledValue(int value) : m_value(value) {}
+
+    PooledValue twice() const { return PooledValue(m_value * 2); }
+
+    int value() const { return m_value; }
+
+private:
+    int m_value;
+};
+
+#ifdef __cpp_aligned_new
+class alignas(64) PooledAligned
+    : public luabridge::RefCountedObjectType<int, luabridge::PooledDelete>
+{
+public:
+    char payload[16];
+};
+#endif // __cpp_aligned_new
+
+// Released during the static destruction, after the free lists of the main thread
+luabridge::RefCountedObjectPtr<PooledShared> staticPooled;
+
+} // namespace
+
+TEST_F(RefCountedObjectTests, AtomicCounterSharedBetweenThreads)
+{
+    std::atomic<int> deletions(0);
+    luabridge::RefCountedObjectPtr<AtomicRefCounted> object(new AtomicRefCounted(deletions));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([object] {
+            for (int j = 0; j < 10000; ++j)
+            {
+                luabridge::RefCountedObjectPtr<AtomicRefCounted> copy(object);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(1, object->getReferenceCount());
+    ASSERT_EQ(0, deletions);
+
+    object = nullptr;
+    ASSERT_EQ(1, deletions);
+}
+
+TEST_F(RefCountedObjectTests, PooledDeleteReusesMemory)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Pooled>("Pooled")
+        .addProperty("deleted", &Pooled::isDeleted)
+        .endClass();
+
+    bool deleted = false;
+    Pooled* const rawPtr = new Pooled(deleted);
+    luabridge::setGlobal(L, luabridge::RefCountedObjectPtr<Pooled>(rawPtr), "object");
+    runLua("result = object.deleted");
+    ASSERT_FALSE(result<bool>());
+
+    runLua("object = nil result = nil");
+    lua_gc(L, LUA_GCCOLLECT, 1);
+    ASSERT_TRUE(deleted);
+
+    bool deletedNew = false;
+    luabridge::RefCountedObjectPtr<Pooled> ptr(new Pooled(deletedNew));
+    ASSERT_EQ(rawPtr, ptr.getObject());
+    ASSERT_FALSE(deletedNew);
+}
+
+TEST_F(RefCountedObjectTests, PooledDeleteConstructsValuesInUserdata)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<PooledValue>("PooledValue")
+        .addConstructor<void (*)(int)>()
+        .addFunction("twice", &PooledValue::twice)
+        .addProperty("value", &PooledValue::value)
+        .endClass();
+
+    runLua("result = PooledValue (21):twice ().value");
+    ASSERT_EQ(42, result<int>());
+
+    luabridge::setGlobal(L, PooledValue(5), "object");
+    runLua("result = object.value");
+    ASSERT_EQ(5, result<int>());
+}
+
+#ifdef __cpp_aligned_new
+TEST_F(RefCountedObjectTests, PooledDeleteAlignsOverAlignedClasses)
+{
+    std::vector<luabridge::RefCountedObjectPtr<PooledAligned>> objects;
+    for (int i = 0; i < 64; ++i)
+    {
+        objects.emplace_back(new PooledAligned);
+        ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(objects.back().getObject()) % 64);
+    }
+}
+#endif // __cpp_aligned_new
+
+TEST_F(RefCountedObjectTests, PooledDeleteReusesMemoryReleasedByAnotherThread)
+{
+    std::vector<luabridge::RefCountedObjectPtr<PooledShared>> objects;
+    std::vector<PooledShared*> rawPtrs;
+    for (int i = 0; i < 200; ++i)
+    {
+        objects.emplace_back(new PooledShared);
+        rawPtrs.push_back(objects.back().getObject());
+    }
+
+    std::thread([&objects] { objects.clear(); }).join();
+
+    luabridge::RefCountedObjectPtr<PooledShared> ptr(new PooledShared);
+    ASSERT_NE(rawPtrs.end(), std::find(rawPtrs.begin(), rawPtrs.end(), ptr.getObject()));
+
+    staticPooled = ptr;
+}
@@ -6,7 +6,11 @@
 
 #include "LuaBridge/RefCountedPtr.h"
 
+#include <chrono>
 #include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
 
 class RefCountedPtrTests : public ::testing::Test, private luabridge::detail::RefCountedPtrBase
 {
@@ -297,3 +301,140 @@ TEST_F(RefCountedPtrTests, CompareOperators)
     ASSERT_TRUE(rawPtr2 != ptr1);
     ASSERT_TRUE(ptr1 != rawPtr2);
 }
+
+namespace {
+
+/**
+  Copy and destroy a pointer from several threads at once.
+*/
+template<class RefCounts>
+void copyFromThreads(luabridge::RefCountedPtr<int, RefCounts> const& ptr,
+                     unsigned threadCount,
+                     int copyCount)
+{
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([&ptr, copyCount] {
+            for (int j = 0; j < copyCount; ++j)
+            {
+                luabridge::RefCountedPtr<int, RefCounts> copy(ptr);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+} // namespace
+
+TEST_F(RefCountedPtrTests, ShardedRefCounts)
+{
+    bool deleted = false;
+    {
+        luabridge::RefCountedPtr<TestObject, luabridge::ShardedRefCounts> ptr(
+            new TestObject(deleted));
+        const luabridge::RefCountedPtr<TestObject, luabridge::ShardedRefCounts> ptrCopy(ptr);
+        ASSERT_EQ(ptr.use_count(), 2);
+        ASSERT_EQ(getNumRefCounts(), 0);
+
+        ptr.reset();
+        ASSERT_EQ(ptrCopy.use_count(), 1);
+        ASSERT_FALSE(deleted);
+    }
+
+    ASSERT_TRUE(deleted);
+
+    const luabridge::RefCountedPtr<int, luabridge::ShardedRefCounts> shared(new int(1));
+    copyFromThreads(shared, 4, 10000);
+    ASSERT_EQ(shared.use_count(), 1);
+}
+
+TEST_F(RefCountedPtrTests, ThreadLocalRefCounts)
+{
+    bool deleted = false;
+    {
+        luabridge::RefCountedPtr<TestObject, luabridge::ThreadLocalRefCounts> ptr(
+            new TestObject(deleted));
+        const luabridge::RefCountedPtr<TestObject, luabridge::ThreadLocalRefCounts> ptrCopy(ptr);
+        ASSERT_EQ(ptr.use_count(), 2);
+        ASSERT_EQ(getNumRefCounts(), 0);
+
+        ptr.reset();
+        ASSERT_EQ(ptrCopy.use_count(), 1);
+        ASSERT_FALSE(deleted);
+    }
+
+    ASSERT_TRUE(deleted);
+
+    int countInThread = 0;
+    std::thread thread([&countInThread] {
+        const luabridge::RefCountedPtr<int, luabridge::ThreadLocalRefCounts> ptr(new int(1));
+        const luabridge::RefCountedPtr<int, luabridge::ThreadLocalRefCounts> ptrCopy(ptr);
+        countInThread = ptr.use_count();
+    });
+    thread.join();
+    ASSERT_EQ(countInThread, 2);
+}
+
+//------------------------------------------------------------------------------
+/**
+  Throughput of the reference count policies, disabled by default as the
+  other performance tests.
+*/
+struct RefCountedPtrPerformanceTests : RefCountedPtrTests
+{
+    static unsigned getThreadCount()
+    {
+        unsigned const count = std::thread::hardware_concurrency();
+        return count != 0 ? count : 4;
+    }
+
+    /**
+      Time the copies of a pointer to a distinct object in each thread.
+    */
+    template<class RefCounts>
+    static void timeCopies(char const* name, unsigned threadCount)
+    {
+        int const copyCount = 10000000;
+
+        auto const start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([] {
+                const luabridge::RefCountedPtr<int, RefCounts> ptr(new int(0));
+                for (int j = 0; j < copyCount; ++j)
+                {
+                    luabridge::RefCountedPtr<int, RefCounts> copy(ptr);
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::chrono::duration<double> const seconds = std::chrono::steady_clock::now() - start;
+        std::cout << name << ", " << threadCount << " thread(s): "
+                  << copyCount * static_cast<double>(threadCount) / seconds.count()
+                  << " copies/s" << std::endl;
+    }
+};
+
+TEST_F(RefCountedPtrPerformanceTests, CopyThroughput)
+{
+    unsigned const threadCount = getThreadCount();
+
+    // The global table cannot be used from several threads
+    timeCopies<luabridge::GlobalRefCounts>("GlobalRefCounts", 1);
+    timeCopies<luabridge::ShardedRefCounts>("ShardedRefCounts", 1);
+    timeCopies<luabridge::ShardedRefCounts>("ShardedRefCounts", threadCount);
+    timeCopies<luabridge::ThreadLocalRefCounts>("ThreadLocalRefCounts", 1);
+    timeCopies<luabridge::ThreadLocalRefCounts>("ThreadLocalRefCounts", threadCount);
+}
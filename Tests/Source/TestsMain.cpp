@@ -9,7 +9,7 @@ int main(int argc, char** argv)
     // Disable performance tests by default
     if (argc == 1)
     {
-        testing::GTEST_FLAG(filter) = "-PerformanceTests.AllTests";
+        testing::GTEST_FLAG(filter) = "-*PerformanceTests.*";
     }
 
     testing::InitGoogleTest(&argc, argv);
@@ -91,3 +91,22 @@ TEST_F(VectorTests, PassFromLua)
 
     ASSERT_EQ(std::vector<Data>({-3, 4}), result<std::vector<Data>>());
 }
+
+TEST_F(VectorTests, ReadsTheArrayPartInOrder)
+{
+    runLua("result = setmetatable ({}, {__len = function () return 100 end, "
+           "                            __newindex = function () error ('newindex') end}) "
+           "for i = 1, 50 do rawset (result, i, i) end "
+           "rawset (result, 'name', 'ignored')");
+
+    std::vector<int> expected;
+    for (int i = 1; i <= 50; ++i)
+    {
+        expected.push_back(i);
+    }
+    ASSERT_EQ(expected, result<std::vector<int>>());
+
+    luabridge::setGlobal(L, expected, "result");
+    runLua("result = #result == 50 and result [1] == 1 and result [50] == 50");
+    ASSERT_TRUE(result<bool>());
+}